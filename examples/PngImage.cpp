@@ -40,11 +40,12 @@ bool PngImage::AllocImageMemory(unsigned int Width, unsigned int Height, const p
         {
             return false;
         }
-        Create(Width, Height);
+        // libpng decodes straight into the buffer with its own row size, image just adopts it
+        Adopt(new uint8_t[m_RowSize * Height], Width, Height, m_RowSize);
         m_pRows = new png_bytep[Height];
         for (unsigned int y = 0; y < m_Height; ++y)
         {
-            m_pRows[y] = reinterpret_cast<png_byte *>(m_RawData + y * m_RowSize);
+            m_pRows[y] = reinterpret_cast<png_byte *>(*GetRow(y));
         }
     }
     return true;
@@ -0,0 +1,139 @@
+#include <cstdio>
+#include <random>
+#include "Image/GrayImage.hpp"
+#include "Utils/CpuFeatures.hpp"
+/*!
+ *  \file
+ *  \brief SIMD parity check
+ *
+ *  GrayImage kernels selected with CpuFeatures (scalar, SSSE3 or SSE4.1 and AVX2) should give bit-exact results.
+ *  Every width from 1 to 1001 is converted, so all the tails of 16 and 32 pixel blocks are covered,
+ *  for both 3 (RGB24) and 4 (RGBA32) byte strides.
+ *  Kernels which the CPU doesn't support are skipped. Returns non-zero on mismatch.
+ */
+
+using namespace jimlib;
+
+namespace
+{
+    const uint32_t MaxWidth = 1001;
+    const uint32_t Height = 3;
+
+    struct Level
+    {
+        const char *Name;
+        uint32_t Mask; //< Features enabled for the kernels
+        uint32_t Required; //< Level is skipped if CPU doesn't have it
+    };
+
+    // Levels are per kernel: each one is run only if the CPU has the features of its SIMD variant
+    const Level ConvertLevels[] = {{"SSSE3", CpuFeature::SSSE3, CpuFeature::SSSE3},
+                                   {"AVX2",  CpuFeature::All,   CpuFeature::AVX2}};
+    const Level LUTLevels[] = {{"SSE4.1", CpuFeature::SSSE3 | CpuFeature::SSE41, CpuFeature::SSE41},
+                               {"AVX2",   CpuFeature::All,                       CpuFeature::AVX2}};
+
+    bool Same(const GrayImage &Left, const GrayImage &Right)
+    {
+        if (Left.GetWidth() != Right.GetWidth() || Left.GetHeight() != Right.GetHeight())
+        {
+            return false;
+        }
+        for (uint32_t y = 0; y < Left.GetHeight(); ++y)
+        {
+            for (uint32_t x = 0; x < Left.GetWidth(); ++x)
+            {
+                if (Left.GetPixel(x, y, 0) != Right.GetPixel(x, y, 0))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    template<typename Pixel>
+    uint32_t CheckConvert(const char *Type, std::mt19937 &Random)
+    {
+        uint32_t Errors = 0;
+        GenericImage<Pixel> Src;
+        GrayImage Reference;
+        GrayImage Result;
+        for (uint32_t Width = 1; Width <= MaxWidth; ++Width)
+        {
+            Src.Create(Width, Height);
+            for (auto it = Src.begin(); it != Src.end(); ++it)
+            {
+                for (uint8_t p = 0; p < GenericImage<Pixel>::Plants; ++p)
+                {
+                    it[p] = (uint8_t) Random();
+                }
+            }
+            CpuFeatures::SetMask(0);
+            Reference.Convert(Src);
+            for (const Level &L : ConvertLevels)
+            {
+                CpuFeatures::SetMask(L.Mask);
+                if (!CpuFeatures::Has(L.Required))
+                {
+                    continue;
+                }
+                Result.Convert(Src);
+                if (!Same(Reference, Result))
+                {
+                    printf("Convert %s: %s differs from scalar at width %u\n", Type, L.Name, Width);
+                    ++Errors;
+                }
+            }
+        }
+        return Errors;
+    }
+
+    uint32_t CheckLUT(std::mt19937 &Random)
+    {
+        uint32_t Errors = 0;
+        uint8_t LUT[256];
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            LUT[i] = (uint8_t) Random();
+        }
+        GrayImage Src;
+        GrayImage Reference;
+        GrayImage Result;
+        for (uint32_t Width = 1; Width <= MaxWidth; ++Width)
+        {
+            Src.Create(Width, Height);
+            for (auto it = Src.begin(); it != Src.end(); ++it)
+            {
+                it[0] = (uint8_t) Random();
+            }
+            CpuFeatures::SetMask(0);
+            Reference.ApplyLUT(Src, LUT);
+            for (const Level &L : LUTLevels)
+            {
+                CpuFeatures::SetMask(L.Mask);
+                if (!CpuFeatures::Has(L.Required))
+                {
+                    continue;
+                }
+                Result.ApplyLUT(Src, LUT);
+                if (!Same(Reference, Result))
+                {
+                    printf("ApplyLUT: %s differs from scalar at width %u\n", L.Name, Width);
+                    ++Errors;
+                }
+            }
+        }
+        return Errors;
+    }
+};
+
+int main()
+{
+    std::mt19937 Random(2015);
+    uint32_t Errors = CheckConvert<PixelType::RGB24>("RGB24", Random);
+    Errors += CheckConvert<PixelType::RGBA32>("RGBA32", Random);
+    Errors += CheckLUT(Random);
+    CpuFeatures::SetMask(CpuFeature::All);
+    printf("SIMD parity (available: 0x%x): %u mismatches\n", CpuFeatures::Get(), Errors);
+    return (Errors == 0) ? 0 : 1;
+}
@@ -26,10 +26,99 @@
 #ifndef JIMLIB_CONVOLUTION2D_HPP
 #define JIMLIB_CONVOLUTION2D_HPP
 
+#include <algorithm>
+#include <limits>
 #include <memory>
+#include <type_traits>
+#include <vector>
 #include "Image/GenericImage.hpp"
+#include "Utils/CpuFeatures.hpp"
+#include "Utils/ThreadPool.hpp"
 namespace jimlib
 {
+    /*!
+     * Values outside of the image for the N-tap convolutions.
+     */
+    namespace ConvolutionBorder
+    {
+        const uint8_t Zero = 0; //< Missing neighbours are skipped (same as convolve3_*)
+        const uint8_t Replicate = 1; //< Edge pixels are repeated: a a | a b c
+        const uint8_t Reflect = 2; //< Image is mirrored at the edge: b a | a b c
+    };
+
+    /*!
+     * Kernel known at compile time, e.g. Kernel<1, 4, 6, 4, 1>(): the taps are unrolled into the inner loops
+     * (zero taps are dropped).
+     */
+    template<int32_t... Taps>
+    struct Kernel
+    {
+        static const uint32_t Size = sizeof...(Taps);
+        static const uint32_t Radius = sizeof...(Taps) / 2;
+    };
+
+    namespace ConvolutionDetail
+    {
+        /*!
+         * Taps applied one by one (the recursion is inlined into a single expression).
+         */
+        template<int32_t... Taps>
+        struct Unrolled;
+
+        template<>
+        struct Unrolled<>
+        {
+            template<typename T, typename SrcType>
+            static T Sum(const SrcType *)
+            { return T(0); }
+            template<typename T>
+            static T SumRows(const T *const *, size_t)
+            { return T(0); }
+        };
+
+        template<int32_t Tap, int32_t... Taps>
+        struct Unrolled<Tap, Taps...>
+        {
+            /*!
+             * Sum of Tap * pSrc[j] along the row.
+             */
+            template<typename T, typename SrcType>
+            static T Sum(const SrcType *pSrc)
+            { return (Tap == 0 ? T(0) : T(Tap) * T(pSrc[0])) + Unrolled<Taps...>::template Sum<T>(pSrc + 1); }
+
+            /*!
+             * Sum of Tap * pRows[j][x] along the column.
+             */
+            template<typename T>
+            static T SumRows(const T *const *pRows, size_t x)
+            {
+                return (Tap == 0 ? T(0) : T(Tap) * pRows[0][x]) +
+                       Unrolled<Taps...>::template SumRows<T>(pRows + 1, x);
+            }
+        };
+
+        /*!
+         * \return Index of the i-th value of the line of Size values with the Border, -1 if it is skipped.
+         */
+        inline int64_t MapBorder(int64_t i, uint32_t Size, uint8_t Border)
+        {
+            while (i < 0 || i >= Size)
+            {
+                if (Border == ConvolutionBorder::Zero)
+                {
+                    return -1;
+                }
+                if (Border == ConvolutionBorder::Replicate)
+                {
+                    return (i < 0) ? 0 : Size - 1;
+                }
+                // Reflected as many times as the kernel is longer than the line
+                i = (i < 0) ? -i - 1 : 2 * (int64_t) Size - i - 1;
+            }
+            return i;
+        }
+    };
+
     template<typename OutputT, typename InputT>
     class Convolution2D : public GenericImage<GenericPixel<OutputT, 1>>
     {
@@ -40,6 +129,86 @@ namespace jimlib
         template<typename Pixel>
         void convolve3_vertical(const GenericImage<Pixel> &Src, InputT k1, InputT k2, InputT k3);
         void convolve3_vertical(InputT k1, InputT k2, InputT k3);
+
+        /*!
+         * Convolve rows of the Src with the compile-time kernel, e.g. convolve_horizontal(Src, Kernel<1, 2, 1>()).
+         */
+        template<typename Pixel, int32_t... Taps>
+        void convolve_horizontal(const GenericImage<Pixel> &Src, Kernel<Taps...>,
+                                 uint8_t Border = ConvolutionBorder::Zero);
+
+        /*!
+         * Convolve rows of the Src with the odd-length runtime kernel (AVX2 if available).
+         */
+        template<typename Pixel>
+        void convolve_horizontal(const GenericImage<Pixel> &Src, const std::vector<InputT> &Kernel,
+                                 uint8_t Border = ConvolutionBorder::Zero);
+
+        /*!
+         * Convolve columns in place with the compile-time kernel.
+         */
+        template<int32_t... Taps>
+        void convolve_vertical(Kernel<Taps...>, uint8_t Border = ConvolutionBorder::Zero);
+
+        /*!
+         * Convolve columns in place with the odd-length runtime kernel (AVX2 if available).
+         */
+        void convolve_vertical(const std::vector<InputT> &Kernel, uint8_t Border = ConvolutionBorder::Zero);
+
+        /*!
+         * Fixed-point result to Dst: Dst = (Value + 2^(Shift - 1)) >> Shift saturated to the range of Dst,
+         * e.g. Shift = 8 after Kernel<1, 4, 6, 4, 1>() along both axes.
+         */
+        template<typename Pixel>
+        void convert_saturated(GenericImage<Pixel> &Dst, uint8_t Shift = 0) const;
+    private:
+        static const uint32_t StripSize = 1024; //< Columns of the vertical pass at once (the ring fits into L1)
+
+        template<typename Pixel, typename Interior>
+        void HorizontalPass(const GenericImage<Pixel> &Src, const std::vector<InputT> &Kernel, uint8_t Border,
+                            Interior Row);
+
+        template<typename Interior>
+        void VerticalPass(const std::vector<InputT> &Kernel, uint8_t Border, Interior Row);
+
+        /*!
+         * pDst[x] = Sum Kernel[j] * pSrc[x + j] for Count values.
+         */
+        template<typename SrcType>
+        static void HorizontalRow(const SrcType *pSrc, const InputT *pKernel, uint32_t Taps, OutputT *pDst,
+                                  size_t Count);
+
+        template<typename SrcType>
+        using HorizontalRowFunction = void (*)(const SrcType *pSrc, const InputT *pKernel, uint32_t Taps,
+                                               OutputT *pDst, size_t Count);
+
+        template<typename SrcType>
+        static HorizontalRowFunction<SrcType> SelectHorizontalRow();
+
+        /*!
+         * pDst[x] = Sum Kernel[j] * pRows[j][x] for Count values (rows that are nullptr are skipped).
+         */
+        static void VerticalRow(const OutputT *const *pRows, const InputT *pKernel, uint32_t Taps, OutputT *pDst,
+                                size_t Count);
+
+        typedef void (*VerticalRowFunction)(const OutputT *const *pRows, const InputT *pKernel, uint32_t Taps,
+                                            OutputT *pDst, size_t Count);
+
+        static VerticalRowFunction SelectVerticalRow();
+
+#ifdef JIMLIB_HAS_X86_SIMD
+        /*!
+         * HorizontalRow() and VerticalRow() compiled for AVX2 (the loops are vectorized by the compiler).
+         */
+        template<typename SrcType>
+        __attribute__((target("avx2")))
+        static void HorizontalRowAVX2(const SrcType *pSrc, const InputT *pKernel, uint32_t Taps, OutputT *pDst,
+                                      size_t Count);
+
+        __attribute__((target("avx2")))
+        static void VerticalRowAVX2(const OutputT *const *pRows, const InputT *pKernel, uint32_t Taps,
+                                    OutputT *pDst, size_t Count);
+#endif
     };
     
     template<typename OutputT, typename InputT>
@@ -138,7 +307,9 @@ namespace jimlib
         {
             return;
         }
-        std::unique_ptr<OutputT[]> buf(new OutputT[W]);
+        GenericImage<GenericPixel<OutputT, 1>> Row;
+        Row.Create(W, 1);
+        OutputT *buf = *Row.begin();
         auto it_2 = this->begin();
         auto it_3 = this->GetRow(1);
         for (int32_t x = 0; x < W; ++x, ++it_2, ++it_3)
@@ -160,6 +331,319 @@ namespace jimlib
             it_2[0] = k1*buf[x] + k2*it_2[0];
         }
     }
+
+    template<typename OutputT, typename InputT>
+    template<typename Pixel, int32_t... Taps>
+    void Convolution2D<OutputT, InputT>::convolve_horizontal(const GenericImage<Pixel> &Src, Kernel<Taps...>,
+                                                             uint8_t Border)
+    {
+        static_assert(sizeof...(Taps) % 2 == 1, "Kernel should have an odd amount of taps!");
+        std::vector<InputT> Weights = {Taps...};
+        HorizontalPass(Src, Weights, Border, [](const typename Pixel::Type *pSrc, OutputT *pDst, size_t Count)
+        {
+            for (size_t x = 0; x < Count; ++x)
+            {
+                pDst[x] = ConvolutionDetail::Unrolled<Taps...>::template Sum<OutputT>(pSrc + x);
+            }
+        });
+    }
+
+    template<typename OutputT, typename InputT>
+    template<typename Pixel>
+    void Convolution2D<OutputT, InputT>::convolve_horizontal(const GenericImage<Pixel> &Src,
+                                                             const std::vector<InputT> &Kernel, uint8_t Border)
+    {
+        auto Function = SelectHorizontalRow<typename Pixel::Type>();
+        const InputT *pKernel = Kernel.data();
+        uint32_t Taps = (uint32_t) Kernel.size();
+        HorizontalPass(Src, Kernel, Border, [&](const typename Pixel::Type *pSrc, OutputT *pDst, size_t Count)
+        {
+            Function(pSrc, pKernel, Taps, pDst, Count);
+        });
+    }
+
+    template<typename OutputT, typename InputT>
+    template<int32_t... Taps>
+    void Convolution2D<OutputT, InputT>::convolve_vertical(Kernel<Taps...>, uint8_t Border)
+    {
+        static_assert(sizeof...(Taps) % 2 == 1, "Kernel should have an odd amount of taps!");
+        std::vector<InputT> Weights = {Taps...};
+        VerticalPass(Weights, Border, [](const OutputT *const *pRows, OutputT *pDst, size_t Count)
+        {
+            for (size_t x = 0; x < Count; ++x)
+            {
+                pDst[x] = ConvolutionDetail::Unrolled<Taps...>::template SumRows<OutputT>(pRows, x);
+            }
+        });
+    }
+
+    template<typename OutputT, typename InputT>
+    void Convolution2D<OutputT, InputT>::convolve_vertical(const std::vector<InputT> &Kernel, uint8_t Border)
+    {
+        auto Function = SelectVerticalRow();
+        const InputT *pKernel = Kernel.data();
+        uint32_t Taps = (uint32_t) Kernel.size();
+        VerticalPass(Kernel, Border, [&](const OutputT *const *pRows, OutputT *pDst, size_t Count)
+        {
+            Function(pRows, pKernel, Taps, pDst, Count);
+        });
+    }
+
+    template<typename OutputT, typename InputT>
+    template<typename Pixel>
+    void Convolution2D<OutputT, InputT>::convert_saturated(GenericImage<Pixel> &Dst, uint8_t Shift) const
+    {
+        typedef typename Pixel::Type Type;
+        static_assert(Pixel::Plants == 1, "Only 1-plant images are allowed");
+        static_assert(std::is_integral<OutputT>::value && std::is_integral<Type>::value && sizeof(Type) <= 4,
+                      "Fixed-point output is for integer sums and pixels up to 32 bits");
+        uint32_t W = this->GetWidth();
+        uint32_t H = this->GetHeight();
+        if (Dst.GetWidth() != W || Dst.GetHeight() != H)
+        {
+            Dst.Create(W, H);
+        }
+        const int64_t Half = (Shift > 0) ? (int64_t) 1 << (Shift - 1) : 0;
+        const int64_t Low = std::numeric_limits<Type>::min();
+        const int64_t High = std::numeric_limits<Type>::max();
+        ParallelRows(Dst, [&](uint32_t First, uint32_t Last, uint32_t)
+        {
+            for (uint32_t y = First; y < Last; ++y)
+            {
+                const OutputT *pSrc = *this->GetRow(y);
+                Type *pDst = *Dst.GetRow(y);
+                for (uint32_t x = 0; x < W; ++x)
+                {
+                    int64_t Value = ((int64_t) pSrc[x] + Half) >> Shift;
+                    pDst[x] = (Type) (Value < Low ? Low : (Value > High ? High : Value));
+                }
+            }
+        });
+    }
+
+    template<typename OutputT, typename InputT>
+    template<typename Pixel, typename Interior>
+    void Convolution2D<OutputT, InputT>::HorizontalPass(const GenericImage<Pixel> &Src,
+                                                        const std::vector<InputT> &Kernel, uint8_t Border,
+                                                        Interior Row)
+    {
+        static_assert(Pixel::Plants == 1, "Only 1-plant images are allowed");
+        assert(Kernel.size() % 2 == 1);
+        uint32_t W = Src.GetWidth();
+        uint32_t H = Src.GetHeight();
+        this->Create(W, H);
+        uint32_t Taps = (uint32_t) Kernel.size();
+        uint32_t R = Taps / 2;
+        // Columns [Begin, End) have all the taps inside of the row
+        uint32_t Begin = std::min(R, W);
+        uint32_t End = std::max(Begin, (W > R) ? W - R : 0);
+        ParallelRows(Src, [&](uint32_t First, uint32_t Last, uint32_t)
+        {
+            for (uint32_t y = First; y < Last; ++y)
+            {
+                const typename Pixel::Type *pSrc = *Src.GetRow(y);
+                OutputT *pDst = *this->GetRow(y);
+                Row(pSrc + Begin - R, pDst + Begin, End - Begin);
+                auto BorderSum = [&](uint32_t x)
+                {
+                    OutputT Sum = 0;
+                    for (uint32_t j = 0; j < Taps; ++j)
+                    {
+                        int64_t i = ConvolutionDetail::MapBorder((int64_t) x + j - R, W, Border);
+                        if (i >= 0)
+                        {
+                            Sum += OutputT(Kernel[j]) * OutputT(pSrc[i]);
+                        }
+                    }
+                    pDst[x] = Sum;
+                };
+                for (uint32_t x = 0; x < Begin; ++x)
+                {
+                    BorderSum(x);
+                }
+                for (uint32_t x = End; x < W; ++x)
+                {
+                    BorderSum(x);
+                }
+            }
+        });
+    }
+
+    template<typename OutputT, typename InputT>
+    template<typename Interior>
+    void Convolution2D<OutputT, InputT>::VerticalPass(const std::vector<InputT> &Kernel, uint8_t Border,
+                                                      Interior Row)
+    {
+        assert(Kernel.size() % 2 == 1);
+        uint32_t W = this->GetWidth();
+        uint32_t H = this->GetHeight();
+        if (W < 1 || H < 1)
+        {
+            return;
+        }
+        uint32_t Taps = (uint32_t) Kernel.size();
+        uint32_t R = Taps / 2;
+        auto Function = SelectVerticalRow();
+        // Same ring as in convolve3_vertical(): R source rows above the current one are kept aside
+        // (row y in the slot y % R), the rows below aren't overwritten yet
+        uint32_t Workers = ThreadPool::GetDefault()->GetWorkers();
+        uint32_t Strip = StripSize;
+        Strip = std::min(Strip, ((W + Workers - 1) / Workers + 63) / 64 * 64);
+        uint32_t Strips = (W + Strip - 1) / Strip;
+        ThreadPool::GetDefault()->ParallelFor(0, Strips, [&](uint32_t First, uint32_t Last, uint32_t)
+        {
+            std::vector<OutputT> Buffer((size_t) (R + 1) * Strip);
+            OutputT *pSum = Buffer.data();
+            OutputT *pRing = pSum + Strip;
+            std::vector<const OutputT *> Rows(Taps);
+            for (uint32_t x = First * Strip; x < W && x < Last * Strip; x += Strip)
+            {
+                uint32_t Count = std::min(Strip, W - x);
+                for (uint32_t y = 0; y < H; ++y)
+                {
+                    bool Inside = true;
+                    for (uint32_t j = 0; j < Taps; ++j)
+                    {
+                        int64_t i = ConvolutionDetail::MapBorder((int64_t) y + j - R, H, Border);
+                        if (i < 0)
+                        {
+                            Rows[j] = nullptr;
+                            Inside = false;
+                        }
+                        else if (i < y)
+                        {
+                            Rows[j] = pRing + (size_t) (i % R) * Strip;
+                        }
+                        else
+                        {
+                            Rows[j] = *this->GetRow((uint32_t) i) + x;
+                        }
+                    }
+                    if (Inside)
+                    {
+                        Row(Rows.data(), pSum, Count);
+                    }
+                    else
+                    {
+                        Function(Rows.data(), Kernel.data(), Taps, pSum, Count);
+                    }
+                    OutputT *pDst = *this->GetRow(y) + x;
+                    if (R > 0)
+                    {
+                        std::copy(pDst, pDst + Count, pRing + (size_t) (y % R) * Strip);
+                    }
+                    std::copy(pSum, pSum + Count, pDst);
+                }
+            }
+        });
+    }
+
+    template<typename OutputT, typename InputT>
+    template<typename SrcType>
+    void Convolution2D<OutputT, InputT>::HorizontalRow(const SrcType *pSrc, const InputT *pKernel, uint32_t Taps,
+                                                       OutputT *pDst, size_t Count)
+    {
+        // Tap by tap over the whole row: the inner loop is vectorized
+        std::fill(pDst, pDst + Count, OutputT(0));
+        for (uint32_t j = 0; j < Taps; ++j)
+        {
+            const OutputT k = OutputT(pKernel[j]);
+            const SrcType *p = pSrc + j;
+            for (size_t x = 0; x < Count; ++x)
+            {
+                pDst[x] += k * OutputT(p[x]);
+            }
+        }
+    }
+
+    template<typename OutputT, typename InputT>
+    template<typename SrcType>
+    typename Convolution2D<OutputT, InputT>::template HorizontalRowFunction<SrcType>
+    Convolution2D<OutputT, InputT>::SelectHorizontalRow()
+    {
+#ifdef JIMLIB_HAS_X86_SIMD
+        if (CpuFeatures::Has(CpuFeature::AVX2))
+        {
+            return &HorizontalRowAVX2<SrcType>;
+        }
+#endif
+        return &HorizontalRow<SrcType>;
+    }
+
+    template<typename OutputT, typename InputT>
+    void Convolution2D<OutputT, InputT>::VerticalRow(const OutputT *const *pRows, const InputT *pKernel,
+                                                     uint32_t Taps, OutputT *pDst, size_t Count)
+    {
+        std::fill(pDst, pDst + Count, OutputT(0));
+        for (uint32_t j = 0; j < Taps; ++j)
+        {
+            const OutputT k = OutputT(pKernel[j]);
+            const OutputT *p = pRows[j];
+            if (p == nullptr)
+            {
+                continue;
+            }
+            for (size_t x = 0; x < Count; ++x)
+            {
+                pDst[x] += k * p[x];
+            }
+        }
+    }
+
+    template<typename OutputT, typename InputT>
+    typename Convolution2D<OutputT, InputT>::VerticalRowFunction Convolution2D<OutputT, InputT>::SelectVerticalRow()
+    {
+#ifdef JIMLIB_HAS_X86_SIMD
+        if (CpuFeatures::Has(CpuFeature::AVX2))
+        {
+            return &VerticalRowAVX2;
+        }
+#endif
+        return &VerticalRow;
+    }
+
+#ifdef JIMLIB_HAS_X86_SIMD
+    template<typename OutputT, typename InputT>
+    template<typename SrcType>
+    __attribute__((target("avx2")))
+    void Convolution2D<OutputT, InputT>::HorizontalRowAVX2(const SrcType *pSrc, const InputT *pKernel,
+                                                           uint32_t Taps, OutputT *pDst, size_t Count)
+    {
+        // Same loops as HorizontalRow(), vectorized by the compiler with the 256 bit registers
+        std::fill(pDst, pDst + Count, OutputT(0));
+        for (uint32_t j = 0; j < Taps; ++j)
+        {
+            const OutputT k = OutputT(pKernel[j]);
+            const SrcType *p = pSrc + j;
+            for (size_t x = 0; x < Count; ++x)
+            {
+                pDst[x] += k * OutputT(p[x]);
+            }
+        }
+    }
+
+    template<typename OutputT, typename InputT>
+    __attribute__((target("avx2")))
+    void Convolution2D<OutputT, InputT>::VerticalRowAVX2(const OutputT *const *pRows, const InputT *pKernel,
+                                                         uint32_t Taps, OutputT *pDst, size_t Count)
+    {
+        // Same loops as VerticalRow()
+        std::fill(pDst, pDst + Count, OutputT(0));
+        for (uint32_t j = 0; j < Taps; ++j)
+        {
+            const OutputT k = OutputT(pKernel[j]);
+            const OutputT *p = pRows[j];
+            if (p == nullptr)
+            {
+                continue;
+            }
+            for (size_t x = 0; x < Count; ++x)
+            {
+                pDst[x] += k * p[x];
+            }
+        }
+    }
+#endif
 }
 
 #endif //JIMLIB_CONVOLUTION2D_HPP
@@ -27,9 +27,10 @@
 #define JIMLIB_CANNY_HPP
 
 #include <cmath>
-#include <set>
+#include <vector>
 #include "Image/BinaryImage.hpp"
 #include "Image/GrayImage.hpp"
+#include "Image/Histogram.hpp"
 #include "EdgeDetection/Sobel.hpp"
 #include "Processing/Cluster.hpp"
 
@@ -38,7 +39,10 @@ namespace jimlib
     class Canny
     {
     public:
-        void Calculate(const GenericImage<PixelType::Mono8> &Src, BinaryImage &Dst, int32_t T1, int32_t T2, float sigma1 = 0.33, float sigma2 = 0.33);
+        /*!
+         * Smoothing > 0 takes the gradient of the recursive Gaussian of that sigma instead of the Sobel kernels.
+         */
+        void Calculate(const GenericImage<PixelType::Mono8> &Src, BinaryImage &Dst, int32_t T1, int32_t T2, float sigma1 = 0.33, float sigma2 = 0.33, double Smoothing = 0);
     private:
         static constexpr int32_t FACTOR = 100;
         static constexpr int32_t TH1 = (int32_t)(FACTOR*tan(M_PI/8));
@@ -46,10 +50,10 @@ namespace jimlib
         BinaryImage m_nonMaxSuppressed;
         GrayImage m_Mass;
         Cluster m_Clusters;
-        std::set<int16_t> m_Lookup;
+        std::vector<uint8_t> m_Lookup;
     };
     
-    void Canny::Calculate(const GenericImage<PixelType::Mono8> &Src, BinaryImage &Dst, int32_t T1, int32_t T2, float sigma1, float sigma2)
+    void Canny::Calculate(const GenericImage<PixelType::Mono8> &Src, BinaryImage &Dst, int32_t T1, int32_t T2, float sigma1, float sigma2, double Smoothing)
     {
         assert(T2 > T1);
         bool Auto = false;
@@ -66,13 +70,23 @@ namespace jimlib
         
         Dst.Create(W,H,PixelType::Mono8(0));
         Sobel grad;
-        grad.Calculate(Src, 255);
+        if (Smoothing > 0)
+        {
+            grad.CalculateSmoothed(Src, Smoothing, 255);
+        }
+        else
+        {
+            grad.Calculate(Src, 255);
+        }
         auto gx = grad.GetGx();
         auto gy = grad.GetGy();
         auto magn = grad.GetMagnitude();
         if (Auto)
         {
-            int32_t mean_ = mean<int32_t>(*magn);
+            // magnitude is normalized to [0, 255]
+            Histogram Histo;
+            Histo.Calculate(*magn);
+            int32_t mean_ = (int32_t) Histo.GetMean();
             T1 = (int32_t)(max(0.0, (1.0 - sigma1) * mean_));
             T2 = (int32_t)(min(255.0, (1.0 + sigma2) * mean_));
         }
@@ -150,27 +164,23 @@ namespace jimlib
                 }
             }
         }
-        int16_t clusterAmount = m_Clusters.ClusterizeMask(m_Mass, m_nonMaxSuppressed);
-        m_Lookup.clear();
-        for (int16_t i = 0; i < clusterAmount; ++i)
+        uint16_t clusterAmount = m_Clusters.ClusterizeMask(m_Mass, m_nonMaxSuppressed);
+        m_Lookup.assign(clusterAmount, 0);
+        for (uint32_t i = 0; i < clusterAmount; ++i)
         {
             const ClusterItem &item = m_Clusters.GetCluster(i);
             if (item.Mass > 0)
             {
-                m_Lookup.insert(i);
+                m_Lookup[i] = 1;
             }
         }
         auto it_src = m_Clusters.begin();
         auto it_dst = Dst.begin();
         for (; it_dst != Dst.end(); ++it_dst, ++it_src)
         {
-            if (it_src[0] != Cluster::MaxIdx)
+            if (it_src[0] != Cluster::MaxIdx && m_Lookup[it_src[0]])
             {
-                auto search = m_Lookup.find(it_src[0]);
-                if (search != m_Lookup.end())
-                {
-                    it_dst[0] = 1;
-                }
+                it_dst[0] = 1;
             }
         }
     }
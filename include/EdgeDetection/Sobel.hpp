@@ -28,6 +28,8 @@
 
 #include <cmath>
 #include "Convolution/Convolution.hpp"
+#include "Image/ImageExpression.hpp"
+#include "Processing/RecursiveGaussian.hpp"
 #include "Utils/Search.hpp"
 
 namespace jimlib
@@ -37,10 +39,17 @@ namespace jimlib
     public:
         template<class Pixel>
         void Calculate(const GenericImage<Pixel> &Src, int32_t norm = 0);
+        /*!
+         * Gradient of the Src smoothed by the recursive Gaussian of Sigma (instead of the 3x3 Sobel kernels),
+         * Gx and Gy are scaled to the Sobel ones and rounded. It suppresses the noise of the larger scale at the same cost.
+         */
+        template<class Pixel>
+        void CalculateSmoothed(const GenericImage<Pixel> &Src, double Sigma, int32_t norm = 0);
         const Convolution2D<int32_t, int32_t> *GetGx() const;
         const Convolution2D<int32_t, int32_t> *GetGy() const;
         const GenericImage<GenericPixel<int32_t, 1>> *GetMagnitude() const;
     private:
+        void CalculateMagnitude(int32_t norm);
         Convolution2D<int32_t, int32_t> m_Gx;
         Convolution2D<int32_t, int32_t> m_Gy;
         GenericImage<GenericPixel<int32_t, 1>> m_Magnitude;
@@ -49,42 +58,46 @@ namespace jimlib
     template<class Pixel>
     void Sobel::Calculate(const GenericImage<Pixel> &Src, int32_t norm)
     {
-        int32_t W = Src.GetWidth();
-        int32_t H = Src.GetHeight();
         m_Gx.convolve3_horizontal(Src, 1, 0, -1);
         m_Gx.convolve3_vertical(1, 2, 1);
         m_Gy.convolve3_horizontal(Src, 1, 2, 1);
         m_Gy.convolve3_vertical(1, 0, -1);
-        m_Magnitude.Create(W,H);
-        
-        auto it_m = m_Magnitude.begin();
-        auto it_gx = m_Gx.begin();
-        auto it_gy = m_Gy.begin();
-        for (; it_m != m_Magnitude.end(); ++it_m, ++it_gx, ++it_gy)
-        {
-            it_m[0] = (int32_t)sqrt(it_gx[0]*it_gx[0] + it_gy[0]*it_gy[0]);
-        }
+        CalculateMagnitude(norm);
+    }
+    
+    template<class Pixel>
+    void Sobel::CalculateSmoothed(const GenericImage<Pixel> &Src, double Sigma, int32_t norm)
+    {
+        RecursiveGaussian::GradientImage Gx;
+        RecursiveGaussian::GradientImage Gy;
+        RecursiveGaussian::Gradient(Src, Gx, Gy, Sigma);
+        // Sobel kernels are 8 times the derivative of the opposite sign
+        Evaluate(m_Gx, Cast<int32_t>(Round(-8.0f * Gx)));
+        Evaluate(m_Gy, Cast<int32_t>(Round(-8.0f * Gy)));
+        CalculateMagnitude(norm);
+    }
+    
+    inline void Sobel::CalculateMagnitude(int32_t norm)
+    {
+        Evaluate(m_Magnitude, Sqrt(m_Gx * m_Gx + m_Gy * m_Gy));
         if (norm > 0)
         {
             int32_t max_ = max(m_Magnitude);
-            for (auto it = m_Magnitude.begin(); it != m_Magnitude.end(); ++it)
-            {
-                it[0] = (int32_t)(norm*it[0]/max_);
-            }
+            Evaluate(m_Magnitude, norm * m_Magnitude / max_);
         }
     }
     
-    const Convolution2D<int32_t, int32_t> *Sobel::GetGx() const
+    inline const Convolution2D<int32_t, int32_t> *Sobel::GetGx() const
     {
         return &m_Gx;
     }
     
-    const Convolution2D<int32_t, int32_t> *Sobel::GetGy() const
+    inline const Convolution2D<int32_t, int32_t> *Sobel::GetGy() const
     {
         return &m_Gy;
     }
     
-    const GenericImage<GenericPixel<int32_t, 1>> *Sobel::GetMagnitude() const
+    inline const GenericImage<GenericPixel<int32_t, 1>> *Sobel::GetMagnitude() const
     {
         return &m_Magnitude;
     }
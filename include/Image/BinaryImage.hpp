@@ -27,20 +27,56 @@
 #define JIMLIB_BINARYIMAGE_HPP
 
 #include <cmath>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+#include "Image/Histogram.hpp"
 #include "Image/IntegralImage.hpp"
+#include "Image/ImageBand.hpp"
+#include "Utils/ThreadPool.hpp"
 namespace jimlib
 {
+    class PackedBinaryImage;
+    template<typename Pixel>
+    class StreamingBinarizer;
+
     class BinaryImage : public GenericImage<PixelType::Mono8>
     {
+        friend class PackedBinaryImage;
+        template<typename Pixel>
+        friend class StreamingBinarizer;
     public:
+        /*!
+         * Otsu binarization of Mono8 or Mono16 image. Histogram has one bin per value by default,
+         * or Bins (power of two) buckets of values.
+         */
         template <typename Pixel>
-        void Otsu(const GenericImage<Pixel> &Src);
+        void Otsu(const GenericImage<Pixel> &Src, uint32_t Bins = 0);
         template <typename Pixel>
         void Niblack(const GenericImage<Pixel> &Src, uint32_t WindowSize, double K);
         template <typename Pixel>
         void Sauvola(const GenericImage<Pixel> &Src, uint32_t WindowSize, double K);
         template <typename Pixel>
         void BoxMean(const GenericImage<Pixel> &Src, uint32_t WindowSize, double K);
+
+        /*!
+         * Banded versions of the binarizations for images which don't fit into memory.
+         * Src is read by bands of BandHeight rows (plus WindowSize / 2 rows above and below),
+         * binarized bands are passed to Dst. Only one band is kept in memory (it is left in this image).
+         * Result is the same as binarization of the whole image.
+         */
+        template <typename Pixel>
+        void Otsu(BandReader<Pixel> &Src, BandWriter<PixelType::Mono8> &Dst, uint32_t BandHeight = 256);
+        template <typename Pixel>
+        void Niblack(BandReader<Pixel> &Src, BandWriter<PixelType::Mono8> &Dst, uint32_t WindowSize, double K,
+                     uint32_t BandHeight = 256);
+        template <typename Pixel>
+        void Sauvola(BandReader<Pixel> &Src, BandWriter<PixelType::Mono8> &Dst, uint32_t WindowSize, double K,
+                     uint32_t BandHeight = 256);
+        template <typename Pixel>
+        void BoxMean(BandReader<Pixel> &Src, BandWriter<PixelType::Mono8> &Dst, uint32_t WindowSize, double K,
+                     uint32_t BandHeight = 256);
+
         template <typename Pixel>
         void ThresholdUp(const GenericImage<Pixel> &Src, typename Pixel::Type Threshold);
         template <typename Pixel>
@@ -48,6 +84,85 @@ namespace jimlib
         void Invert();
         void CopyFrom(const BinaryImage &Src);
         void CopyTo(BinaryImage &Dst) const;
+    private:
+        class NiblackFunction
+        {
+        public:
+            NiblackFunction(double K) : m_K(K) {}
+            double operator()(double Mx, double Mx2) const;
+        private:
+            double m_K;
+        };
+
+        class SauvolaFunction
+        {
+        public:
+            SauvolaFunction(uint32_t WindowSize, double K) : m_WindowSize(WindowSize), m_K(K) {}
+            double operator()(double Mx, double Mx2) const;
+        private:
+            uint32_t m_WindowSize;
+            double m_K;
+        };
+
+        class BoxMeanFunction
+        {
+        public:
+            BoxMeanFunction(double K) : m_K(K) {}
+            double operator()(double Mx, double Mx2) const;
+        private:
+            double m_K;
+        };
+
+        /*!
+         * pDst[x] = 1 if pSrc[x] is above Threshold(Mx, Mx2) of its window: Mx = pSum[x] * pScale[x] and
+         * Mx2 = pSq[x] * pScale[x] (pScale is 1 / Area of the window). StreamingBinarizer binarizes rows with
+         * the same loop, so both round the same way: with -ffast-math the loop-invariant 1 / Area of the interior
+         * would be folded into the threshold otherwise.
+         */
+        template<typename T, typename Function>
+        static void BinarizeRow(const T *pSrc, const double *pSum, const double *pSq, const double *pScale,
+                                uint32_t Count, const Function &Threshold, uint8_t *pDst);
+
+        /*!
+         * Destination of the LocalThreshold() rows: Begin() gives the buffer for the row, End() is called
+         * when the row is filled. Rows are filled by several workers at once (Worker is the ThreadPool one).
+         */
+        class ByteRowSink
+        {
+        public:
+            ByteRowSink(GenericImage<PixelType::Mono8> &Dst) : m_Dst(Dst) {}
+            uint8_t *Begin(uint32_t Row, uint32_t Worker);
+            void End(uint32_t Row, uint32_t Worker);
+        private:
+            GenericImage<PixelType::Mono8> &m_Dst;
+        };
+
+        /*!
+         * \return Otsu threshold of Src in values (the last value of the darker class).
+         */
+        template <typename Pixel>
+        static typename Pixel::Type OtsuThreshold(const GenericImage<Pixel> &Src, uint32_t Bins);
+
+        /*!
+         * Binarize rows [FirstRow, LastRow) of Src into the rows of Sink (starting from 0) by the threshold
+         * Function(Mean, SquaredMean) of the WindowSize neighbourhood. SquaredMean is calculated only if Squared.
+         * Near the borders the window is clipped by the image and the means are taken over the clipped area.
+         */
+        template <bool Squared, typename Pixel, typename Function, typename Sink>
+        static void LocalThreshold(const GenericImage<Pixel> &Src, uint32_t FirstRow, uint32_t LastRow,
+                                   uint32_t WindowSize, Function Threshold, Sink &Dst);
+
+        /*!
+         * LocalThreshold() with the Integral image of Src: IntegralImage or DualIntegralImage if Squared
+         * (of 32 bit sums if they are exact for the window).
+         */
+        template <bool Squared, typename Pixel, typename Sums, typename Function, typename Sink>
+        static void LocalThreshold(const GenericImage<Pixel> &Src, const Sums &Integral, uint32_t FirstRow,
+                                   uint32_t LastRow, uint32_t WindowSize, Function Threshold, Sink &Dst);
+
+        template <bool Squared, typename Pixel, typename Function>
+        void LocalThreshold(BandReader<Pixel> &Src, BandWriter<PixelType::Mono8> &Dst, uint32_t WindowSize,
+                            uint32_t BandHeight, Function Threshold);
     };
 
 // =======================================================
@@ -68,20 +183,26 @@ namespace jimlib
         static_assert(GenericImage<Pixel>::Plants == 1, "Binary image supports only images with 1 plant.");
         uint32_t W = Src.GetWidth();
         uint32_t H = Src.GetHeight();
-        Create(W, H, PixelType::Mono8(0));
-        typename GenericImage<Pixel>::const_iterator it_src = Src.begin();
-        BinaryImage::iterator it_dst = begin();
-        for (; it_src != Src.end(); ++it_src, ++it_dst)
+        Create(W, H);
+        ParallelRows(*this, [&](uint32_t First, uint32_t Last, uint32_t)
         {
-            if (it_src[0] > Threshold)
+            for (uint32_t y = First; y < Last; ++y)
             {
-                it_dst[0] = 1;
-            }
-            else
-            {
-                it_dst[0] = 0;
+                typename GenericImage<Pixel>::const_iterator it_src = Src.GetRow(y);
+                BinaryImage::iterator it_dst = GetRow(y);
+                for (uint32_t x = 0; x < W; ++x, ++it_src, ++it_dst)
+                {
+                    if (it_src[0] > Threshold)
+                    {
+                        it_dst[0] = 1;
+                    }
+                    else
+                    {
+                        it_dst[0] = 0;
+                    }
+                }
             }
-        }
+        });
     }
     template <typename Pixel>
     void BinaryImage::ThresholdDown(const GenericImage<Pixel> &Src, typename Pixel::Type Threshold)
@@ -89,175 +210,270 @@ namespace jimlib
         static_assert(GenericImage<Pixel>::Plants == 1, "Binary image supports only images with 1 plant.");
         uint32_t W = Src.GetWidth();
         uint32_t H = Src.GetHeight();
-        Create(W, H, PixelType::Mono8(0));
-        typename GenericImage<Pixel>::const_iterator it_src = Src.begin();
-        BinaryImage::iterator it_dst = begin();
-        for (; it_src != Src.end(); ++it_src, ++it_dst)
+        Create(W, H);
+        ParallelRows(*this, [&](uint32_t First, uint32_t Last, uint32_t)
         {
-            if (it_src[0] < Threshold)
-            {
-                it_dst[0] = 1;
-            }
-            else
+            for (uint32_t y = First; y < Last; ++y)
             {
-                it_dst[0] = 0;
+                typename GenericImage<Pixel>::const_iterator it_src = Src.GetRow(y);
+                BinaryImage::iterator it_dst = GetRow(y);
+                for (uint32_t x = 0; x < W; ++x, ++it_src, ++it_dst)
+                {
+                    if (it_src[0] < Threshold)
+                    {
+                        it_dst[0] = 1;
+                    }
+                    else
+                    {
+                        it_dst[0] = 0;
+                    }
+                }
             }
-        }
+        });
     }
 
     template <typename Pixel>
-    void BinaryImage::Otsu(const GenericImage<Pixel> &Src)
+    typename Pixel::Type BinaryImage::OtsuThreshold(const GenericImage<Pixel> &Src, uint32_t Bins)
     {
         static_assert(GenericImage<Pixel>::Plants == 1, "Binary image supports only images with 1 plant.");
-        typename GenericImage<Pixel>::const_iterator it_src = Src.begin();
-        uint32_t Histo[256];
-        memset(Histo, 0, sizeof(Histo));
-        for (; it_src != Src.end(); ++it_src)
+        typedef typename Pixel::Type Type;
+        uint32_t Shift = Histogram::GetShift<Type>(Bins);
+        Histogram Histo(Histogram::GetLevels<Type>() >> Shift);
+        Histo.Calculate(Src, 0, Shift);
+        return (Type) Histogram::GetLastValue(Histo.GetOtsuThreshold(), Shift);
+    }
+
+    template <typename Pixel>
+    void BinaryImage::Otsu(const GenericImage<Pixel> &Src, uint32_t Bins)
+    {
+        ThresholdUp(Src, OtsuThreshold(Src, Bins));
+    }
+
+    template <typename Pixel>
+    void BinaryImage::Otsu(BandReader<Pixel> &Src, BandWriter<PixelType::Mono8> &Dst, uint32_t BandHeight)
+    {
+        static_assert(GenericImage<Pixel>::Plants == 1, "Binary image supports only images with 1 plant.");
+        assert(BandHeight > 0);
+        uint32_t W = Src.GetWidth();
+        uint32_t H = Src.GetHeight();
+        GenericImage<Pixel> Band;
+        Histogram Histo(Histogram::GetLevels<typename Pixel::Type>());
+        for (uint32_t y = 0; y < H; y += BandHeight)
         {
-            ++Histo[it_src[0]];
+            Band.Create(W, std::min(BandHeight, H - y));
+            Src.Read(y, Band);
+            Histo.Accumulate(Band);
         }
-        uint32_t Energy = 0;
-        uint32_t Sum = 0;
-        for (uint32_t i = 0; i <= 255; ++i)
+        typename Pixel::Type Threshold = Histo.GetOtsuThreshold();
+        for (uint32_t y = 0; y < H; y += BandHeight)
         {
-            Energy += i * Histo[i];
-            Sum += Histo[i];
+            Band.Create(W, std::min(BandHeight, H - y));
+            Src.Read(y, Band);
+            ThresholdUp(Band, Threshold);
+            Dst.Write(y, *this);
         }
-        uint32_t PartialEnergy = 0;
-        uint32_t PartialSum = 0;
-        typename Pixel::Type Threshold = 0;
-        double w1 = 0;
-        double a = 0;
-        double Sigma = 0;
-        double MaxSigma = -1;
-        for (uint32_t i = 0; i <= 255; ++i)
+    }
+
+    inline double BinaryImage::NiblackFunction::operator()(double Mx, double Mx2) const
+    {
+        double StdDev = sqrt(Mx2 - Mx * Mx);
+        return Mx + m_K * StdDev;
+    }
+
+    inline double BinaryImage::SauvolaFunction::operator()(double Mx, double Mx2) const
+    {
+        double StdDev = sqrt(Mx2 - Mx * Mx);
+        return Mx * (1 + m_K * (StdDev / (m_WindowSize / 2) - 1));
+    }
+
+    inline double BinaryImage::BoxMeanFunction::operator()(double Mx, double) const
+    {
+        return Mx * m_K;
+    }
+
+    template<typename T, typename Function>
+    void BinaryImage::BinarizeRow(const T *pSrc, const double *pSum, const double *pSq, const double *pScale,
+                                  uint32_t Count, const Function &Threshold, uint8_t *pDst)
+    {
+        for (uint32_t x = 0; x < Count; ++x)
         {
-            PartialEnergy += i * Histo[i];
-            PartialSum += Histo[i];
-            w1 = (double) PartialSum / Sum;
-            a = (double) PartialEnergy / PartialSum - (double) (Energy - PartialEnergy) / (Sum - PartialSum);
-            Sigma = w1 * (1 - w1) * a * a;
-            if (Sigma > MaxSigma)
-            {
-                MaxSigma = Sigma;
-                Threshold = i;
-            }
+            pDst[x] = (pSrc[x] > Threshold(pSum[x] * pScale[x], pSq[x] * pScale[x])) ? 1 : 0;
         }
-        Create(Src.GetWidth(), Src.GetHeight(), PixelType::Mono8(0));
-        BinaryImage::iterator it_dst = begin();
-        it_src = Src.begin();
-        for (; it_src != Src.end(); ++it_src, ++it_dst)
+    }
+
+    inline uint8_t *BinaryImage::ByteRowSink::Begin(uint32_t Row, uint32_t)
+    {
+        return *m_Dst.GetRow(Row);
+    }
+
+    inline void BinaryImage::ByteRowSink::End(uint32_t, uint32_t)
+    {
+    }
+
+    template <bool Squared, typename Pixel, typename Function, typename Sink>
+    void BinaryImage::LocalThreshold(const GenericImage<Pixel> &Src, uint32_t FirstRow, uint32_t LastRow,
+                                     uint32_t WindowSize, Function Threshold, Sink &Dst)
+    {
+        static_assert(GenericImage<Pixel>::Plants == 1, "Binary image supports only images with 1 plant.");
+        // Window sums wrap around, so 32 bit sums are enough if the sum of the whole window fits
+        uint64_t Side = WindowSize / 2 * 2 + 1;
+        if (IntegralImage32::IsExact<Pixel>(Side * Side, Squared))
         {
-            if (it_src[0] > Threshold)
-            {
-                it_dst[0] = 1;
-            }
-            else
-            {
-                it_dst[0] = 0;
-            }
+            typename std::conditional<Squared, DualIntegralImage32, IntegralImage32>::type Integral;
+            Integral.Calculate(Src);
+            LocalThreshold<Squared>(Src, Integral, FirstRow, LastRow, WindowSize, Threshold, Dst);
+        }
+        else
+        {
+            typename std::conditional<Squared, DualIntegralImage, IntegralImage>::type Integral;
+            Integral.Calculate(Src);
+            LocalThreshold<Squared>(Src, Integral, FirstRow, LastRow, WindowSize, Threshold, Dst);
         }
     }
 
-    template <typename Pixel>
-    void BinaryImage::Niblack(const GenericImage<Pixel> &Src, uint32_t WindowSize, double K)
+    template <bool Squared, typename Pixel, typename Sums, typename Function, typename Sink>
+    void BinaryImage::LocalThreshold(const GenericImage<Pixel> &Src, const Sums &Integral, uint32_t FirstRow,
+                                     uint32_t LastRow, uint32_t WindowSize, Function Threshold, Sink &Dst)
     {
-        static_assert(GenericImage<Pixel>::Plants == 1, "Binary image supports only images with 1 plant.");
-        IntegralImage Mean;
-        IntegralImage Mean2;
-        Mean.Calculate(Src);
-        Mean2.CalculateSquared(Src);
+        typedef typename Sums::SumType SumType;
+        // Sums and squared sums are interleaved in one image (Stride 2), so both are read from the same lines
+        const uint32_t Stride = Sums::Plants;
         uint32_t W = Src.GetWidth();
         uint32_t H = Src.GetHeight();
-        Create(W, H, PixelType::Mono8(0));
-        typename GenericImage<Pixel>::const_iterator it_src = Src.begin();
-        BinaryImage::iterator it_dst = begin();
-        double Sq = (1 + WindowSize) * (1 + WindowSize);
-        for (uint32_t y = 0; y < H; ++y)
+        uint32_t Half = WindowSize / 2;
+        // Row above the first one
+        std::vector<SumType> Zeros((size_t) W * Stride, 0);
+        ThreadPool::GetDefault()->ParallelFor(FirstRow, LastRow, [&](uint32_t First, uint32_t Last, uint32_t Worker)
         {
-            for (uint32_t x = 0; x < W; ++x, ++it_src, ++it_dst)
+            // Window sums and 1 / Area of the row, binarized by BinarizeRow()
+            std::vector<double> Window((size_t) 3 * W);
+            double *pSum = Window.data();
+            double *pSq = pSum + W;
+            double *pScale = pSq + W;
+            for (uint32_t y = First; y < Last; ++y)
             {
-                Rect<int32_t> rc(y - WindowSize / 2, x - WindowSize / 2, y + WindowSize / 2, x + WindowSize / 2);
-                double Mx = Mean.GetSum(rc) / Sq;
-                double Mx2 = Mean2.GetSum(rc) / Sq;
-                double StdDev = sqrt(Mx2 - Mx * Mx);
-                double Threshold = Mx + K * StdDev;
-                if (it_src[0] > Threshold)
+                // Window is clipped by the image, so its area is calculated for the clipped window
+                uint32_t Top = (y > Half) ? y - Half : 0;
+                uint32_t Bottom = std::min(H - 1, y + Half);
+                double Rows = Bottom - Top + 1;
+                const SumType *pSumBottom = *Integral.GetRow(Bottom);
+                const SumType *pSumTop = (Top > 0) ? *Integral.GetRow(Top - 1) : Zeros.data();
+                // Squared sums are used only if Squared
+                const SumType *pSqBottom = pSumBottom + 1;
+                const SumType *pSqTop = pSumTop + 1;
+                auto Border = [&](uint32_t x)
+                {
+                    uint32_t Left = (x > Half) ? x - Half : 0;
+                    uint32_t Right = std::min(W - 1, x + Half);
+                    SumType Sum = pSumBottom[Stride * Right] - pSumTop[Stride * Right];
+                    SumType Sq = Squared ? pSqBottom[Stride * Right] - pSqTop[Stride * Right] : 0;
+                    if (Left > 0)
+                    {
+                        Sum -= pSumBottom[Stride * (Left - 1)] - pSumTop[Stride * (Left - 1)];
+                        if (Squared)
+                        {
+                            Sq -= pSqBottom[Stride * (Left - 1)] - pSqTop[Stride * (Left - 1)];
+                        }
+                    }
+                    pSum[x] = Sum;
+                    pSq[x] = Sq;
+                    pScale[x] = 1.0 / (Rows * (Right - Left + 1));
+                };
+                // Interior: the whole window row is inside the image, no clipping and the same area
+                uint32_t InteriorBegin = std::min(W, Half + 1);
+                uint32_t InteriorEnd = (W > Half) ? std::max(InteriorBegin, W - Half) : InteriorBegin;
+                for (uint32_t x = 0; x < InteriorBegin; ++x)
+                {
+                    Border(x);
+                }
+                double Scale = 1.0 / (Rows * (2 * Half + 1));
+                for (uint32_t x = InteriorBegin; x < InteriorEnd; ++x)
                 {
-                    it_dst[0] = 1;
+                    size_t Right = (size_t) Stride * (x + Half);
+                    size_t Left = (size_t) Stride * (x - Half - 1);
+                    SumType Sum = pSumBottom[Right] - pSumBottom[Left] - pSumTop[Right] + pSumTop[Left];
+                    SumType Sq = Squared ? pSqBottom[Right] - pSqBottom[Left] - pSqTop[Right] + pSqTop[Left] : 0;
+                    pSum[x] = Sum;
+                    pSq[x] = Sq;
+                    pScale[x] = Scale;
                 }
-                else
+                for (uint32_t x = InteriorEnd; x < W; ++x)
                 {
-                    it_dst[0] = 0;
+                    Border(x);
                 }
+                BinarizeRow(*Src.GetRow(y), pSum, pSq, pScale, W, Threshold, Dst.Begin(y - FirstRow, Worker));
+                Dst.End(y - FirstRow, Worker);
             }
-        }
+        }, 16384 / std::max(1u, W) + 1);
     }
 
-    template <typename Pixel>
-    void BinaryImage::Sauvola(const GenericImage<Pixel> &Src, uint32_t WindowSize, double K)
+    template <bool Squared, typename Pixel, typename Function>
+    void BinaryImage::LocalThreshold(BandReader<Pixel> &Src, BandWriter<PixelType::Mono8> &Dst, uint32_t WindowSize,
+                                     uint32_t BandHeight, Function Threshold)
     {
-        static_assert(GenericImage<Pixel>::Plants == 1, "Binary image supports only images with 1 plant.");
-        IntegralImage Mean;
-        IntegralImage StdDevIntegral;
-        Mean.Calculate(Src);
-        StdDevIntegral.CalculateSquared(Src);
+        assert(BandHeight > 0);
         uint32_t W = Src.GetWidth();
         uint32_t H = Src.GetHeight();
-        Create(W, H, PixelType::Mono8(0));
-        typename GenericImage<Pixel>::const_iterator it_src = Src.begin();
-        BinaryImage::iterator it_dst = begin();
-        double Sq = (1 + WindowSize) * (1 + WindowSize);
-        for (uint32_t y = 0; y < H; ++y)
+        uint32_t Halo = WindowSize / 2;
+        GenericImage<Pixel> Band;
+        for (uint32_t y = 0; y < H; y += BandHeight)
         {
-            for (uint32_t x = 0; x < W; ++x, ++it_src, ++it_dst)
-            {
-                Rect<int32_t> rc(y - WindowSize / 2, x - WindowSize / 2, y + WindowSize / 2, x + WindowSize / 2);
-                double Mx = Mean.GetSum(rc) / Sq;
-                double Mx2 = StdDevIntegral.GetSum(rc) / Sq;
-                double StdDev = sqrt(Mx2 - Mx * Mx);
-                double Threshold = Mx * (1 + K * (StdDev / (WindowSize / 2) - 1));
-                if (it_src[0] > Threshold)
-                {
-                    it_dst[0] = 1;
-                }
-                else
-                {
-                    it_dst[0] = 0;
-                }
-            }
+            // Window of the band rows should see exactly the same rows as in the whole image.
+            uint32_t Rows = std::min(BandHeight, H - y);
+            uint32_t Top = (y > Halo) ? y - Halo : 0;
+            uint32_t Bottom = (uint32_t) std::min<uint64_t>((uint64_t) y + Rows + Halo, H);
+            Band.Create(W, Bottom - Top);
+            Src.Read(Top, Band);
+            Create(W, Rows);
+            ByteRowSink Sink(*this);
+            LocalThreshold<Squared>(Band, y - Top, y - Top + Rows, WindowSize, Threshold, Sink);
+            Dst.Write(y, *this);
         }
     }
-    
+
+    template <typename Pixel>
+    void BinaryImage::Niblack(const GenericImage<Pixel> &Src, uint32_t WindowSize, double K)
+    {
+        Create(Src.GetWidth(), Src.GetHeight());
+        ByteRowSink Sink(*this);
+        LocalThreshold<true>(Src, 0, Src.GetHeight(), WindowSize, NiblackFunction(K), Sink);
+    }
+
+    template <typename Pixel>
+    void BinaryImage::Niblack(BandReader<Pixel> &Src, BandWriter<PixelType::Mono8> &Dst, uint32_t WindowSize, double K,
+                              uint32_t BandHeight)
+    {
+        LocalThreshold<true>(Src, Dst, WindowSize, BandHeight, NiblackFunction(K));
+    }
+
+    template <typename Pixel>
+    void BinaryImage::Sauvola(const GenericImage<Pixel> &Src, uint32_t WindowSize, double K)
+    {
+        Create(Src.GetWidth(), Src.GetHeight());
+        ByteRowSink Sink(*this);
+        LocalThreshold<true>(Src, 0, Src.GetHeight(), WindowSize, SauvolaFunction(WindowSize, K), Sink);
+    }
+
+    template <typename Pixel>
+    void BinaryImage::Sauvola(BandReader<Pixel> &Src, BandWriter<PixelType::Mono8> &Dst, uint32_t WindowSize, double K,
+                              uint32_t BandHeight)
+    {
+        LocalThreshold<true>(Src, Dst, WindowSize, BandHeight, SauvolaFunction(WindowSize, K));
+    }
+
     template <typename Pixel>
     void BinaryImage::BoxMean(const GenericImage<Pixel> &Src, uint32_t WindowSize, double K)
     {
-        static_assert(GenericImage<Pixel>::Plants == 1, "Binary image supports only images with 1 plant.");
-        IntegralImage Mean;
-        Mean.Calculate(Src);
-        uint32_t W = Src.GetWidth();
-        uint32_t H = Src.GetHeight();
-        Create(W, H, PixelType::Mono8(0));
-        typename GenericImage<Pixel>::const_iterator it_src = Src.begin();
-        BinaryImage::iterator it_dst = begin();
-        double Sq = (1 + WindowSize) * (1 + WindowSize);
-        for (uint32_t y = 0; y < H; ++y)
-        {
-            for (uint32_t x = 0; x < W; ++x, ++it_src, ++it_dst)
-            {
-                Rect<int32_t> rc(y - WindowSize / 2, x - WindowSize / 2, y + WindowSize / 2, x + WindowSize / 2);
-                double Mx = Mean.GetSum(rc) / Sq;
-                double Threshold = Mx * K;
-                if (it_src[0] > Threshold)
-                {
-                    it_dst[0] = 1;
-                }
-                else
-                {
-                    it_dst[0] = 0;
-                }
-            }
-        }
+        Create(Src.GetWidth(), Src.GetHeight());
+        ByteRowSink Sink(*this);
+        LocalThreshold<false>(Src, 0, Src.GetHeight(), WindowSize, BoxMeanFunction(K), Sink);
+    }
+
+    template <typename Pixel>
+    void BinaryImage::BoxMean(BandReader<Pixel> &Src, BandWriter<PixelType::Mono8> &Dst, uint32_t WindowSize, double K,
+                              uint32_t BandHeight)
+    {
+        LocalThreshold<false>(Src, Dst, WindowSize, BandHeight, BoxMeanFunction(K));
     }
 
     inline void BinaryImage::Invert()
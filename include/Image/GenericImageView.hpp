@@ -0,0 +1,179 @@
+/*
+ *  jimlib -- generic image and-image algorithms library
+ *  Copyright (C) 2015 Alexey Titov
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty.  In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ *
+ *  Alexey Titov
+ *  alex.justes@gmail.com
+ *  https://github.com/alex-justes/jimlib
+ */
+
+#ifndef JIMLIB_GENERICIMAGEVIEW_HPP
+#define JIMLIB_GENERICIMAGEVIEW_HPP
+
+#include "Image/GenericImage.hpp"
+#include "Utils/Rect.hpp"
+namespace jimlib
+{
+    /*!
+     * Non-owning view over the rectangular region of another image.
+     *
+     * The view shares parent's buffer and row offset, so it is created without any copy and
+     * can be passed to every algorithm accepting GenericImage<Pixel>. Parent should outlive the view.
+     * Region is given in the same inclusive form as ClusterItem::roi.
+     * The view is writable, so it is created over non-const images only (see ConstGenericImageView).
+     * Its size is fixed: algorithms may Create() it only with the size of the region, other sizes throw
+     * std::logic_error.
+     */
+    template<typename Pixel>
+    class GenericImageView : public GenericImage<Pixel>
+    {
+    public:
+        GenericImageView(GenericImage<Pixel> &Parent, const Rect<uint32_t> &Roi);
+
+        /*!
+         * Copy of the view points to the same region, no pixels are copied.
+         */
+        GenericImageView(const GenericImageView<Pixel> &View);
+
+        /*!
+         * Point to the same region as the View.
+         */
+        GenericImageView<Pixel> &operator=(const GenericImageView<Pixel> &View);
+
+        /*!
+         * \return Region of the parent image covered by the view.
+         */
+        const Rect<uint32_t> &GetRoi() const;
+    private:
+        template<typename>
+        friend class ConstGenericImageView;
+
+        GenericImageView(const uint8_t *pRawData, size_t Offset, const Rect<uint32_t> &Roi);
+        void Attach(const uint8_t *pRawData, size_t Offset);
+        Rect<uint32_t> m_Roi;
+    };
+
+    /*!
+     * Read-only view over the rectangular region of the const image.
+     *
+     * Pixels are reachable only through the const GenericImage<Pixel> returned by GetImage(),
+     * so the parent can't be modified through the view.
+     */
+    template<typename Pixel>
+    class ConstGenericImageView
+    {
+    public:
+        ConstGenericImageView(const GenericImage<Pixel> &Parent, const Rect<uint32_t> &Roi);
+
+        /*!
+         * \return Region as the const image to pass to the algorithms.
+         */
+        const GenericImage<Pixel> &GetImage() const;
+
+        /*!
+         * \return Region of the parent image covered by the view.
+         */
+        const Rect<uint32_t> &GetRoi() const;
+    private:
+        static const uint8_t *GetRawData(const GenericImage<Pixel> &Parent, const Rect<uint32_t> &Roi);
+        GenericImageView<Pixel> m_View;
+    };
+
+// =======================================================
+
+    template<typename Pixel>
+    GenericImageView<Pixel>::GenericImageView(GenericImage<Pixel> &Parent, const Rect<uint32_t> &Roi)
+            : m_Roi(Roi)
+    {
+        assert(Roi.left <= Roi.right && Roi.right < Parent.GetWidth());
+        assert(Roi.top <= Roi.bottom && Roi.bottom < Parent.GetHeight());
+        Attach(reinterpret_cast<const uint8_t *>(*Parent.GetColRow(Roi.left, Roi.top)), Parent.GetOffset());
+    }
+
+    template<typename Pixel>
+    GenericImageView<Pixel>::GenericImageView(const uint8_t *pRawData, size_t Offset, const Rect<uint32_t> &Roi)
+            : m_Roi(Roi)
+    {
+        Attach(pRawData, Offset);
+    }
+
+    template<typename Pixel>
+    GenericImageView<Pixel>::GenericImageView(const GenericImageView<Pixel> &View)
+            : GenericImage<Pixel>(),
+              m_Roi(View.m_Roi)
+    {
+        Attach(View.m_RawData, View.m_Offset);
+    }
+
+    template<typename Pixel>
+    GenericImageView<Pixel> &GenericImageView<Pixel>::operator=(const GenericImageView<Pixel> &View)
+    {
+        if (this != &View)
+        {
+            this->DeleteRawData();
+            m_Roi = View.m_Roi;
+            Attach(View.m_RawData, View.m_Offset);
+        }
+        return *this;
+    }
+
+    template<typename Pixel>
+    void GenericImageView<Pixel>::Attach(const uint8_t *pRawData, size_t Offset)
+    {
+        this->m_Width = m_Roi.right - m_Roi.left + 1;
+        this->m_Height = m_Roi.bottom - m_Roi.top + 1;
+        this->m_Offset = Offset;
+        this->m_BufSize = Offset * (this->m_Height - 1) + (size_t)this->m_Width * GenericImage<Pixel>::SizeOfPixel;
+        this->m_RawData = const_cast<uint8_t *>(pRawData);
+    }
+
+    template<typename Pixel>
+    const Rect<uint32_t> &GenericImageView<Pixel>::GetRoi() const
+    {
+        return m_Roi;
+    }
+
+    template<typename Pixel>
+    ConstGenericImageView<Pixel>::ConstGenericImageView(const GenericImage<Pixel> &Parent, const Rect<uint32_t> &Roi)
+            : m_View(GetRawData(Parent, Roi), Parent.GetOffset(), Roi)
+    {
+    }
+
+    template<typename Pixel>
+    const uint8_t *ConstGenericImageView<Pixel>::GetRawData(const GenericImage<Pixel> &Parent,
+                                                             const Rect<uint32_t> &Roi)
+    {
+        assert(Roi.left <= Roi.right && Roi.right < Parent.GetWidth());
+        assert(Roi.top <= Roi.bottom && Roi.bottom < Parent.GetHeight());
+        return reinterpret_cast<const uint8_t *>(*Parent.GetColRow(Roi.left, Roi.top));
+    }
+
+    template<typename Pixel>
+    const GenericImage<Pixel> &ConstGenericImageView<Pixel>::GetImage() const
+    {
+        return m_View;
+    }
+
+    template<typename Pixel>
+    const Rect<uint32_t> &ConstGenericImageView<Pixel>::GetRoi() const
+    {
+        return m_View.GetRoi();
+    }
+};
+#endif //JIMLIB_GENERICIMAGEVIEW_HPP
@@ -27,73 +27,121 @@
 #define JIMLIB_GENERICPIXEL_HPP
 
 #include <cstdint>
+#include <cstring>
 #include <cassert>
 namespace jimlib
 {
+    template<typename T, uint8_t PlantsAmount>
+    class PixelValue;
+
+    /*!
+     * Lightweight reference to the pixel stored somewhere else (i.e. in the GenericImage buffer).
+     * It never owns the memory, so copying it is just copying the pointer.
+     * Use PixelValue (GenericPixel::ValueType) to hold the pixel itself.
+     */
     template<typename T, uint8_t PlantsAmount = 1>
     class GenericPixel
     {
     public:
         GenericPixel();
         GenericPixel(T * Buffer);
-        GenericPixel(const GenericPixel &p);
-        void CopyTo(GenericPixel &p);
-        virtual ~GenericPixel();
+        void CopyTo(GenericPixel &p) const;
+        void CopyTo(PixelValue<T, PlantsAmount> &p) const;
         T &operator[](uint8_t Plant);
         const T &operator[](uint8_t Plant) const;
         static const uint8_t Plants = PlantsAmount;
         static const uint32_t SizeOfPixel = sizeof(T) * PlantsAmount;
         typedef T Type;
         typedef GenericPixel<T, PlantsAmount> ParentType;
+        typedef PixelValue<T, PlantsAmount> ValueType;
         T * m_Buffer;
-    private:
-        bool m_Allocated;
+    };
+
+    /*!
+     * Pixel value with inline storage. It is trivially copyable and can be constructed at compile time,
+     * so temporaries like PixelType::Mono8(0) never touch the heap.
+     * Plants that are not listed in the constructor are zeroed.
+     */
+    template<typename T, uint8_t PlantsAmount = 1>
+    class PixelValue
+    {
+    public:
+        constexpr PixelValue();
+        template<typename... Args>
+        constexpr PixelValue(T First, Args... Rest);
+        T &operator[](uint8_t Plant);
+        const T &operator[](uint8_t Plant) const;
+        static const uint8_t Plants = PlantsAmount;
+        static const uint32_t SizeOfPixel = sizeof(T) * PlantsAmount;
+        typedef T Type;
+        typedef GenericPixel<T, PlantsAmount> ParentType;
+        typedef PixelValue<T, PlantsAmount> ValueType;
+        T m_Buffer[PlantsAmount];
     };
 
 // =======================================================
 
     template<typename T, uint8_t PlantsAmount>
     GenericPixel<T, PlantsAmount>::GenericPixel()
-    : m_Buffer(nullptr), m_Allocated(true)
+    : m_Buffer(nullptr)
     {
-        m_Buffer = new T[PlantsAmount];
     }
 
     template<typename T, uint8_t PlantsAmount>
     GenericPixel<T, PlantsAmount>::GenericPixel(T * Buffer)
-    : m_Buffer(Buffer), m_Allocated(false)
+    : m_Buffer(Buffer)
+    {
+    }
+
+    template<typename T, uint8_t PlantsAmount>
+    void GenericPixel<T, PlantsAmount>::CopyTo(GenericPixel &p) const
     {
+        memcpy(p.m_Buffer, m_Buffer, SizeOfPixel);
     }
 
     template<typename T, uint8_t PlantsAmount>
-    GenericPixel<T, PlantsAmount>::GenericPixel(const GenericPixel<T, PlantsAmount> &p)
-    : m_Buffer(p.m_Buffer), m_Allocated(false)
+    void GenericPixel<T, PlantsAmount>::CopyTo(PixelValue<T, PlantsAmount> &p) const
     {
+        memcpy(p.m_Buffer, m_Buffer, SizeOfPixel);
     }
 
     template<typename T, uint8_t PlantsAmount>
-    GenericPixel<T, PlantsAmount>::~GenericPixel()
+    T &GenericPixel<T, PlantsAmount>::operator[](uint8_t Plant)
     {
-        if (m_Allocated && m_Buffer != nullptr)
-        {
-            delete[] m_Buffer;
-        }
+        assert(Plant < PlantsAmount);
+        return m_Buffer[Plant];
     }
 
     template<typename T, uint8_t PlantsAmount>
-    void GenericPixel<T, PlantsAmount>::CopyTo(GenericPixel &p)
+    const T &GenericPixel<T, PlantsAmount>::operator[](uint8_t Plant) const
     {
-        memcpy(p.m_Buffer, m_Buffer, sizeof(T) * PlantsAmount);
+        assert(Plant < PlantsAmount);
+        return m_Buffer[Plant];
     }
+
     template<typename T, uint8_t PlantsAmount>
-    T &GenericPixel<T, PlantsAmount>::operator[](uint8_t Plant)
+    constexpr PixelValue<T, PlantsAmount>::PixelValue()
+    : m_Buffer()
+    {
+    }
+
+    template<typename T, uint8_t PlantsAmount>
+    template<typename... Args>
+    constexpr PixelValue<T, PlantsAmount>::PixelValue(T First, Args... Rest)
+    : m_Buffer{First, static_cast<T>(Rest)...}
+    {
+        static_assert(sizeof...(Args) < PlantsAmount, "Too many plants for this PixelValue!");
+    }
+
+    template<typename T, uint8_t PlantsAmount>
+    T &PixelValue<T, PlantsAmount>::operator[](uint8_t Plant)
     {
         assert(Plant < PlantsAmount);
         return m_Buffer[Plant];
     }
 
     template<typename T, uint8_t PlantsAmount>
-    const T &GenericPixel<T, PlantsAmount>::operator[](uint8_t Plant) const
+    const T &PixelValue<T, PlantsAmount>::operator[](uint8_t Plant) const
     {
         assert(Plant < PlantsAmount);
         return m_Buffer[Plant];
@@ -26,25 +26,130 @@
 #ifndef JIMLIB_GRAYIMAGE_HPP
 #define JIMLIB_GRAYIMAGE_HPP
 
+#include <cmath>
+#include <cstring>
+#include <vector>
 #include "Image/GenericImage.hpp"
+#include "Image/Histogram.hpp"
+#include "Image/PlanarImage.hpp"
 #include "Image/PixelTypes.hpp"
+#include "Utils/CpuFeatures.hpp"
+#include "Utils/Search.hpp"
+#include "Utils/ThreadPool.hpp"
 namespace jimlib
 {
     class GrayImage : public GenericImage<PixelType::Mono8>
     {
     public:
+        /*!
+         * Gray = (6969 * R + 23434 * G + 2365 * B) / 32768, uses SSSE3 or AVX2 kernels if CPU supports them
+         * (see CpuFeatures), results of all kernels are the same.
+         */
         template<typename Pixel>
         void Convert(const GenericImage<Pixel> &RGB24Image);
 
         template<typename Pixel>
         void Convert(const GenericImage<Pixel> &Src, uint8_t Plant);
 
+        /*!
+         * Same as Convert() of the interleaved image, but reads R, G and B planes contiguously.
+         */
+        template<typename Pixel>
+        void Convert(const PlanarImage<Pixel> &RGBPlanes);
+
+        template<typename Pixel>
+        void Convert(const PlanarImage<Pixel> &Src, uint8_t Plant);
+
+        /*!
+         * Dst = LUT[Src] for every pixel, SSE4.1/AVX2 versions look up 16/32 pixels at once with pshufb.
+         * Image is resized to the size of Src, Src could be the image itself.
+         */
+        void ApplyLUT(const GenericImage<PixelType::Mono8> &Src, const uint8_t (&LUT)[256]);
+
+        /*!
+         * In-place ApplyLUT().
+         */
+        void ApplyLUT(const uint8_t (&LUT)[256]);
+
         // TODO: Move it to something like ImageProcessing class
+        /*!
+         * V = clamp(k * V + b, 0, 255) (via LUT).
+         */
         void AdjustColor(double k, double b);
 
+        /*!
+         * V = 255 * (V / 255) ^ Gamma, rounded (via LUT).
+         */
+        void AdjustGamma(double Gamma);
+
+        /*!
+         * V = 255 - V (via LUT).
+         */
+        void Invert();
+
+        /*!
+         * Linearly map [Low, High] to [0, 255], values outside are clamped (via LUT).
+         */
+        void StretchContrast(uint8_t Low, uint8_t High);
+
+        /*!
+         * StretchContrast() from the minimum to the maximum of the image.
+         */
+        void StretchContrast();
+
+        /*!
+         * Histogram equalization (via LUT).
+         */
+        void Equalize();
+
+        /*!
+         * Segment Mono8 or Mono16 Src by multi-level Otsu, every pixel gets index of its class (0 - the darkest).
+         * Histogram has Bins (power of two) buckets of values, see Histogram::GetMultiOtsuThresholds().
+         * \return Classes - 1 thresholds (the last value of every class but the brightest).
+         */
+        template<typename Pixel>
+        std::vector<typename Pixel::Type> MultiOtsu(const GenericImage<Pixel> &Src, uint32_t Classes,
+                                                    uint32_t Bins = 256);
+
+        /*!
+         * Every pixel gets amount of Thresholds (ascending) it is greater than.
+         */
+        template<typename Pixel>
+        void Segment(const GenericImage<Pixel> &Src, const std::vector<typename Pixel::Type> &Thresholds);
+
         void CopyFrom(const GrayImage &Src);
 
         void CopyTo(GrayImage &Dst) const;
+    private:
+        typedef void (*ConvertRowFunction)(const uint8_t *pSrc, uint8_t *pDst, uint32_t Width);
+
+        typedef void (*ApplyLUTRowFunction)(const uint8_t *pSrc, uint8_t *pDst, uint32_t Width,
+                                            const uint8_t (&LUT)[256]);
+
+        template<uint32_t Stride>
+        static ConvertRowFunction SelectConvertRow();
+
+        static ApplyLUTRowFunction SelectApplyLUTRow();
+
+        static void ApplyLUTRowScalar(const uint8_t *pSrc, uint8_t *pDst, uint32_t Width, const uint8_t (&LUT)[256]);
+
+        template<uint32_t Stride>
+        static void ConvertRowScalar(const uint8_t *pSrc, uint8_t *pDst, uint32_t Width);
+#ifdef JIMLIB_HAS_X86_SIMD
+        template<uint32_t Stride>
+        __attribute__((target("ssse3")))
+        static void ConvertRowSSSE3(const uint8_t *pSrc, uint8_t *pDst, uint32_t Width);
+
+        template<uint32_t Stride>
+        __attribute__((target("avx2")))
+        static void ConvertRowAVX2(const uint8_t *pSrc, uint8_t *pDst, uint32_t Width);
+
+        __attribute__((target("sse4.1")))
+        static void ApplyLUTRowSSE41(const uint8_t *pSrc, uint8_t *pDst, uint32_t Width, const uint8_t (&LUT)[256]);
+
+        __attribute__((target("avx2")))
+        static void ApplyLUTRowAVX2(const uint8_t *pSrc, uint8_t *pDst, uint32_t Width, const uint8_t (&LUT)[256]);
+#endif
     };
 
 // =======================================================
@@ -54,25 +159,217 @@ namespace jimlib
     {
         static_assert(CheckTypes<Pixel, PixelType::RGB24>::areSame || CheckTypes<Pixel, PixelType::RGBA32>::areSame,
                       "GrayImage.Convert allow only RGB24 or RGBA32 images");
-        Create(RGB24Image.GetWidth(), RGB24Image.GetHeight());
-        GenericImage<PixelType::RGB24>::const_iterator it_src = RGB24Image.begin();
-        GrayImage::iterator it_dst = begin();
-        for (; it_src != RGB24Image.end(); ++it_src, ++it_dst)
+        uint32_t W = RGB24Image.GetWidth();
+        Create(W, RGB24Image.GetHeight());
+        ConvertRowFunction ConvertRow = SelectConvertRow<GenericImage<Pixel>::Plants>();
+        ParallelRows(*this, [&](uint32_t First, uint32_t Last, uint32_t)
+        {
+            for (uint32_t y = First; y < Last; ++y)
+            {
+                ConvertRow(*RGB24Image.GetRow(y), *GetRow(y), W);
+            }
+        });
+    }
+
+    template<typename Pixel>
+    std::vector<typename Pixel::Type> GrayImage::MultiOtsu(const GenericImage<Pixel> &Src, uint32_t Classes,
+                                                           uint32_t Bins)
+    {
+        static_assert(GenericImage<Pixel>::Plants == 1, "MultiOtsu supports only images with 1 plant.");
+        assert(Classes >= 2 && Classes <= 256);
+        typedef typename Pixel::Type Type;
+        uint32_t Shift = Histogram::GetShift<Type>(Bins);
+        Histogram Histo(Histogram::GetLevels<Type>() >> Shift);
+        Histo.Calculate(Src, 0, Shift);
+        std::vector<uint32_t> BinThresholds = Histo.GetMultiOtsuThresholds(Classes);
+        std::vector<Type> Thresholds(BinThresholds.size());
+        for (size_t i = 0; i < BinThresholds.size(); ++i)
+        {
+            Thresholds[i] = (Type) Histogram::GetLastValue(BinThresholds[i], Shift);
+        }
+        Segment(Src, Thresholds);
+        return Thresholds;
+    }
+
+    template<typename Pixel>
+    void GrayImage::Segment(const GenericImage<Pixel> &Src, const std::vector<typename Pixel::Type> &Thresholds)
+    {
+        static_assert(GenericImage<Pixel>::Plants == 1, "Segment supports only images with 1 plant.");
+        assert(Thresholds.size() < 256);
+        uint32_t W = Src.GetWidth();
+        Create(W, Src.GetHeight());
+        ParallelRows(*this, [&](uint32_t First, uint32_t Last, uint32_t)
+        {
+            for (uint32_t y = First; y < Last; ++y)
+            {
+                const typename Pixel::Type *pSrc = *Src.GetRow(y);
+                uint8_t *pDst = *GetRow(y);
+                memset(pDst, 0, W);
+                for (typename Pixel::Type Threshold : Thresholds)
+                {
+                    for (uint32_t x = 0; x < W; ++x)
+                    {
+                        pDst[x] += (pSrc[x] > Threshold);
+                    }
+                }
+            }
+        });
+    }
+
+    template<uint32_t Stride>
+    GrayImage::ConvertRowFunction GrayImage::SelectConvertRow()
+    {
+#ifdef JIMLIB_HAS_X86_SIMD
+        if (CpuFeatures::Has(CpuFeature::AVX2))
+        {
+            return &ConvertRowAVX2<Stride>;
+        }
+        if (CpuFeatures::Has(CpuFeature::SSSE3))
+        {
+            return &ConvertRowSSSE3<Stride>;
+        }
+#endif
+        return &ConvertRowScalar<Stride>;
+    }
+
+    template<uint32_t Stride>
+    void GrayImage::ConvertRowScalar(const uint8_t *pSrc, uint8_t *pDst, uint32_t Width)
+    {
+        for (uint32_t x = 0; x < Width; ++x, pSrc += Stride)
+        {
+            pDst[x] = (6969 * pSrc[0] + 23434 * pSrc[1] + 2365 * pSrc[2]) / 32768;
+        }
+    }
+
+#ifdef JIMLIB_HAS_X86_SIMD
+    /*
+     * Every 16-byte load holds 4 pixels. pshufb widens R, G, B of two pixels into 16-bit lanes
+     * (R G B 0 R G B 0), pmaddwd gives R*6969+G*23434 and B*2365 pairs and phaddd sums them per pixel.
+     * Sum fits into int32, so the result is exactly the same as the scalar one.
+     */
+    template<uint32_t Stride>
+    __attribute__((target("ssse3")))
+    void GrayImage::ConvertRowSSSE3(const uint8_t *pSrc, uint8_t *pDst, uint32_t Width)
+    {
+        const char Z = -128;
+        const char S = Stride;
+        const __m128i Lo = _mm_setr_epi8(0, Z, 1, Z, 2, Z, Z, Z, S, Z, S + 1, Z, S + 2, Z, Z, Z);
+        const __m128i Hi = _mm_setr_epi8(2 * S, Z, 2 * S + 1, Z, 2 * S + 2, Z, Z, Z,
+                                         3 * S, Z, 3 * S + 1, Z, 3 * S + 2, Z, Z, Z);
+        const __m128i K = _mm_setr_epi16(6969, 23434, 2365, 0, 6969, 23434, 2365, 0);
+        uint32_t x = 0;
+        // the last load of the block reads 16 bytes from the pixel x + 12
+        for (; (size_t) (x + 12) * Stride + 16 <= (size_t) Width * Stride; x += 16)
+        {
+            __m128i Sums[4];
+            for (uint32_t k = 0; k < 4; ++k)
+            {
+                __m128i V = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc + (size_t) (x + 4 * k) * Stride));
+                __m128i A = _mm_madd_epi16(_mm_shuffle_epi8(V, Lo), K);
+                __m128i B = _mm_madd_epi16(_mm_shuffle_epi8(V, Hi), K);
+                Sums[k] = _mm_srli_epi32(_mm_hadd_epi32(A, B), 15);
+            }
+            __m128i Gray = _mm_packus_epi16(_mm_packs_epi32(Sums[0], Sums[1]), _mm_packs_epi32(Sums[2], Sums[3]));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(pDst + x), Gray);
+        }
+        ConvertRowScalar<Stride>(pSrc + (size_t) x * Stride, pDst + x, Width - x);
+    }
+
+    /*
+     * Same as SSSE3 version, but the low 128-bit lane holds pixels x..x+15 and the high lane x+16..x+31,
+     * so in-lane packing leaves the result in order.
+     */
+    template<uint32_t Stride>
+    __attribute__((target("avx2")))
+    void GrayImage::ConvertRowAVX2(const uint8_t *pSrc, uint8_t *pDst, uint32_t Width)
+    {
+        const char Z = -128;
+        const char S = Stride;
+        const __m128i Lo128 = _mm_setr_epi8(0, Z, 1, Z, 2, Z, Z, Z, S, Z, S + 1, Z, S + 2, Z, Z, Z);
+        const __m128i Hi128 = _mm_setr_epi8(2 * S, Z, 2 * S + 1, Z, 2 * S + 2, Z, Z, Z,
+                                            3 * S, Z, 3 * S + 1, Z, 3 * S + 2, Z, Z, Z);
+        const __m256i Lo = _mm256_inserti128_si256(_mm256_castsi128_si256(Lo128), Lo128, 1);
+        const __m256i Hi = _mm256_inserti128_si256(_mm256_castsi128_si256(Hi128), Hi128, 1);
+        const __m256i K = _mm256_setr_epi16(6969, 23434, 2365, 0, 6969, 23434, 2365, 0,
+                                            6969, 23434, 2365, 0, 6969, 23434, 2365, 0);
+        uint32_t x = 0;
+        for (; (size_t) (x + 28) * Stride + 16 <= (size_t) Width * Stride; x += 32)
         {
-            it_dst[0] = (6969 * it_src[0] + 23434 * it_src[1] + 2365 * it_src[2]) / 32768;
+            __m256i Sums[4];
+            for (uint32_t k = 0; k < 4; ++k)
+            {
+                const uint8_t *p = pSrc + (size_t) (x + 4 * k) * Stride;
+                __m256i V = _mm256_inserti128_si256(
+                        _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))),
+                        _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * Stride)), 1);
+                __m256i A = _mm256_madd_epi16(_mm256_shuffle_epi8(V, Lo), K);
+                __m256i B = _mm256_madd_epi16(_mm256_shuffle_epi8(V, Hi), K);
+                Sums[k] = _mm256_srli_epi32(_mm256_hadd_epi32(A, B), 15);
+            }
+            __m256i Gray = _mm256_packus_epi16(_mm256_packs_epi32(Sums[0], Sums[1]),
+                                               _mm256_packs_epi32(Sums[2], Sums[3]));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(pDst + x), Gray);
         }
+        ConvertRowSSSE3<Stride>(pSrc + (size_t) x * Stride, pDst + x, Width - x);
     }
+#endif
 
     template<typename Pixel>
     void GrayImage::Convert(const GenericImage<Pixel> &Src, uint8_t Plant)
     {
         assert(Plant < GenericImage<Pixel>::Plants);
-        Create(Src.GetWidth(), Src.GetHeight());
-        typename GenericImage<Pixel>::const_iterator it_src = Src.begin();
-        GrayImage::iterator it_dst = begin();
-        for (; it_src != Src.end(); ++it_src, ++it_dst)
+        uint32_t W = Src.GetWidth();
+        Create(W, Src.GetHeight());
+        ParallelRows(*this, [&](uint32_t First, uint32_t Last, uint32_t)
+        {
+            for (uint32_t y = First; y < Last; ++y)
+            {
+                typename GenericImage<Pixel>::const_iterator it_src = Src.GetRow(y);
+                GrayImage::iterator it_dst = GetRow(y);
+                for (uint32_t x = 0; x < W; ++x, ++it_src, ++it_dst)
+                {
+                    it_dst[0] = it_src[Plant];
+                }
+            }
+        });
+    }
+
+    template<typename Pixel>
+    void GrayImage::Convert(const PlanarImage<Pixel> &RGBPlanes)
+    {
+        static_assert(CheckTypes<Pixel, PixelType::RGB24>::areSame || CheckTypes<Pixel, PixelType::RGBA32>::areSame,
+                      "GrayImage.Convert allow only RGB24 or RGBA32 images");
+        uint32_t W = RGBPlanes.GetWidth();
+        uint32_t H = RGBPlanes.GetHeight();
+        size_t PlaneSize = RGBPlanes.GetPlaneSize();
+        Create(W, H);
+        ParallelRows(*this, [&](uint32_t First, uint32_t Last, uint32_t)
         {
-            it_dst[0] = it_src[Plant];
+            for (uint32_t y = First; y < Last; ++y)
+            {
+                const uint8_t *pR = *RGBPlanes.GetRow(y);
+                const uint8_t *pG = pR + PlaneSize;
+                const uint8_t *pB = pG + PlaneSize;
+                uint8_t *pDst = *GetRow(y);
+                for (uint32_t x = 0; x < W; ++x)
+                {
+                    pDst[x] = (6969 * pR[x] + 23434 * pG[x] + 2365 * pB[x]) / 32768;
+                }
+            }
+        });
+    }
+
+    template<typename Pixel>
+    void GrayImage::Convert(const PlanarImage<Pixel> &Src, uint8_t Plant)
+    {
+        static_assert(sizeof(typename Pixel::Type) == 1, "GrayImage.Convert allow only 8-bit plants");
+        assert(Plant < PlanarImage<Pixel>::Plants);
+        uint32_t W = Src.GetWidth();
+        uint32_t H = Src.GetHeight();
+        Create(W, H);
+        for (uint32_t y = 0; y < H; ++y)
+        {
+            memcpy(*GetRow(y), &Src.GetPixel(0, y, Plant), W);
         }
     }
 
@@ -86,16 +383,189 @@ namespace jimlib
         CopyToInternal(Dst);
     }
 
+    inline void GrayImage::ApplyLUT(const GenericImage<PixelType::Mono8> &Src, const uint8_t (&LUT)[256])
+    {
+        uint32_t W = Src.GetWidth();
+        if (GetWidth() != W || GetHeight() != Src.GetHeight())
+        {
+            Create(W, Src.GetHeight());
+        }
+        ApplyLUTRowFunction ApplyLUTRow = SelectApplyLUTRow();
+        ParallelRows(*this, [&](uint32_t First, uint32_t Last, uint32_t)
+        {
+            for (uint32_t y = First; y < Last; ++y)
+            {
+                ApplyLUTRow(*Src.GetRow(y), *GetRow(y), W, LUT);
+            }
+        });
+    }
+
+    inline void GrayImage::ApplyLUT(const uint8_t (&LUT)[256])
+    {
+        ApplyLUT(*this, LUT);
+    }
+
     inline void GrayImage::AdjustColor(double k, double b)
     {
-        GrayImage::iterator it = begin();
-        for (; it != end(); ++it)
+        uint8_t LUT[256];
+        for (int32_t i = 0; i < 256; ++i)
+        {
+            int32_t V = (k * i + b);
+            V = V < 0 ? 0 : V;
+            V = V > 255 ? 255 : V;
+            LUT[i] = V;
+        }
+        ApplyLUT(LUT);
+    }
+
+    inline void GrayImage::AdjustGamma(double Gamma)
+    {
+        assert(Gamma > 0);
+        uint8_t LUT[256];
+        for (int32_t i = 0; i < 256; ++i)
+        {
+            LUT[i] = (uint8_t) (255.0 * pow(i / 255.0, Gamma) + 0.5);
+        }
+        ApplyLUT(LUT);
+    }
+
+    inline void GrayImage::Invert()
+    {
+        uint8_t LUT[256];
+        for (int32_t i = 0; i < 256; ++i)
         {
-            int32_t V = (k * it[0] + b);
+            LUT[i] = 255 - i;
+        }
+        ApplyLUT(LUT);
+    }
+
+    inline void GrayImage::StretchContrast(uint8_t Low, uint8_t High)
+    {
+        assert(High > Low);
+        uint8_t LUT[256];
+        for (int32_t i = 0; i < 256; ++i)
+        {
+            int32_t V = (i - Low) * 255 / (High - Low);
             V = V < 0 ? 0 : V;
             V = V > 255 ? 255 : V;
-            it[0] = V;
+            LUT[i] = V;
+        }
+        ApplyLUT(LUT);
+    }
+
+    inline void GrayImage::StretchContrast()
+    {
+        uint8_t Low = min(*this);
+        uint8_t High = max(*this);
+        if (High > Low)
+        {
+            StretchContrast(Low, High);
+        }
+    }
+
+    inline void GrayImage::Equalize()
+    {
+        Histogram Histo;
+        Histo.Calculate(*this);
+        uint8_t LUT[256];
+        Histo.GetEqualizationLUT(LUT);
+        ApplyLUT(LUT);
+    }
+
+    inline GrayImage::ApplyLUTRowFunction GrayImage::SelectApplyLUTRow()
+    {
+#ifdef JIMLIB_HAS_X86_SIMD
+        if (CpuFeatures::Has(CpuFeature::AVX2))
+        {
+            return &ApplyLUTRowAVX2;
+        }
+        if (CpuFeatures::Has(CpuFeature::SSE41))
+        {
+            return &ApplyLUTRowSSE41;
+        }
+#endif
+        return &ApplyLUTRowScalar;
+    }
+
+    inline void GrayImage::ApplyLUTRowScalar(const uint8_t *pSrc, uint8_t *pDst, uint32_t Width,
+                                             const uint8_t (&LUT)[256])
+    {
+        for (uint32_t x = 0; x < Width; ++x)
+        {
+            pDst[x] = LUT[pSrc[x]];
+        }
+    }
+
+#ifdef JIMLIB_HAS_X86_SIMD
+    /*
+     * LUT is split into 16 tables of 16 entries. pshufb looks up the low nibble of V in every table,
+     * then the bits 4..7 of V select the right result with a tree of 8 + 4 + 2 + 1 pblendvb (it looks
+     * at the high bit of the byte only, so V shifted left by 3, 2, 1 and 0 gives the bits 4, 5, 6 and 7).
+     */
+    inline __attribute__((target("sse4.1")))
+    void GrayImage::ApplyLUTRowSSE41(const uint8_t *pSrc, uint8_t *pDst, uint32_t Width, const uint8_t (&LUT)[256])
+    {
+        __m128i Tables[16];
+        for (uint32_t k = 0; k < 16; ++k)
+        {
+            Tables[k] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(LUT + 16 * k));
+        }
+        const __m128i LowNibble = _mm_set1_epi8(0x0F);
+        uint32_t x = 0;
+        for (; x + 16 <= Width; x += 16)
+        {
+            __m128i V = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc + x));
+            __m128i Index = _mm_and_si128(V, LowNibble);
+            __m128i Values[16];
+            for (uint32_t k = 0; k < 16; ++k)
+            {
+                Values[k] = _mm_shuffle_epi8(Tables[k], Index);
+            }
+            for (uint32_t Bit = 0, Count = 8; Count > 0; ++Bit, Count /= 2)
+            {
+                __m128i Mask = _mm_slli_epi16(V, 3 - Bit);
+                for (uint32_t k = 0; k < Count; ++k)
+                {
+                    Values[k] = _mm_blendv_epi8(Values[2 * k], Values[2 * k + 1], Mask);
+                }
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(pDst + x), Values[0]);
+        }
+        ApplyLUTRowScalar(pSrc + x, pDst + x, Width - x, LUT);
+    }
+
+    inline __attribute__((target("avx2")))
+    void GrayImage::ApplyLUTRowAVX2(const uint8_t *pSrc, uint8_t *pDst, uint32_t Width, const uint8_t (&LUT)[256])
+    {
+        __m256i Tables[16];
+        for (uint32_t k = 0; k < 16; ++k)
+        {
+            __m128i Table = _mm_loadu_si128(reinterpret_cast<const __m128i *>(LUT + 16 * k));
+            Tables[k] = _mm256_inserti128_si256(_mm256_castsi128_si256(Table), Table, 1);
+        }
+        const __m256i LowNibble = _mm256_set1_epi8(0x0F);
+        uint32_t x = 0;
+        for (; x + 32 <= Width; x += 32)
+        {
+            __m256i V = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pSrc + x));
+            __m256i Index = _mm256_and_si256(V, LowNibble);
+            __m256i Values[16];
+            for (uint32_t k = 0; k < 16; ++k)
+            {
+                Values[k] = _mm256_shuffle_epi8(Tables[k], Index);
+            }
+            for (uint32_t Bit = 0, Count = 8; Count > 0; ++Bit, Count /= 2)
+            {
+                __m256i Mask = _mm256_slli_epi16(V, 3 - Bit);
+                for (uint32_t k = 0; k < Count; ++k)
+                {
+                    Values[k] = _mm256_blendv_epi8(Values[2 * k], Values[2 * k + 1], Mask);
+                }
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(pDst + x), Values[0]);
         }
+        ApplyLUTRowSSE41(pSrc + x, pDst + x, Width - x, LUT);
     }
+#endif
 };
 #endif //JIMLIB_GRAYIMAGE_HPP
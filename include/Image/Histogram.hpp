@@ -0,0 +1,482 @@
+/*
+ *  jimlib -- generic image and-image algorithms library
+ *  Copyright (C) 2015 Alexey Titov
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty.  In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ *
+ *  Alexey Titov
+ *  alex.justes@gmail.com
+ *  https://github.com/alex-justes/jimlib
+ */
+
+#ifndef JIMLIB_HISTOGRAM_HPP
+#define JIMLIB_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+#include "Image/GenericImage.hpp"
+#include "Image/GenericImageView.hpp"
+#include "Image/PixelTypes.hpp"
+#include "Utils/Rect.hpp"
+#include "Utils/ThreadPool.hpp"
+namespace jimlib
+{
+    /*!
+     * Histogram of one plant of an integer image.
+     *
+     * Value goes to the bin Value >> Shift, negative values go to the first bin and values above the
+     * last bin go to the last one (so Mono16 could be counted into 256 bins with Shift 8).
+     * Rows are counted in parallel, every worker counts into its own sub-histograms, which are merged
+     * at the end. For small histograms every worker has 4 copies used by successive pixels,
+     * so runs of equal values don't wait for the store of the previous increment of the same bin.
+     */
+    class Histogram
+    {
+    public:
+        Histogram(uint32_t Bins = 256);
+
+        /*!
+         * Set amount of bins and clear the histogram.
+         */
+        void Create(uint32_t Bins);
+
+        void Clear();
+
+        /*!
+         * Clear and Accumulate().
+         */
+        template<typename Pixel>
+        void Calculate(const GenericImage<Pixel> &Src, uint32_t Plant = 0, uint32_t Shift = 0);
+
+        /*!
+         * Clear and Accumulate() pixels with non-zero Mask (of the same size as Src, e.g. BinaryImage).
+         */
+        template<typename Pixel>
+        void Calculate(const GenericImage<Pixel> &Src, const GenericImage<PixelType::Mono8> &Mask,
+                       uint32_t Plant = 0, uint32_t Shift = 0);
+
+        /*!
+         * Clear and Accumulate() pixels inside of Roi.
+         */
+        template<typename Pixel>
+        void Calculate(const GenericImage<Pixel> &Src, const Rect<uint32_t> &Roi, uint32_t Plant = 0,
+                       uint32_t Shift = 0);
+
+        /*!
+         * Add pixels of Src to the histogram (e.g. to count image band by band).
+         */
+        template<typename Pixel>
+        void Accumulate(const GenericImage<Pixel> &Src, uint32_t Plant = 0, uint32_t Shift = 0);
+
+        template<typename Pixel>
+        void Accumulate(const GenericImage<Pixel> &Src, const GenericImage<PixelType::Mono8> &Mask,
+                        uint32_t Plant = 0, uint32_t Shift = 0);
+
+        template<typename Pixel>
+        void Accumulate(const GenericImage<Pixel> &Src, const Rect<uint32_t> &Roi, uint32_t Plant = 0,
+                        uint32_t Shift = 0);
+
+        uint32_t GetBins() const;
+
+        uint64_t operator[](uint32_t Bin) const;
+
+        const uint64_t *GetData() const;
+
+        /*!
+         * \return Amount of counted pixels.
+         */
+        uint64_t GetTotal() const;
+
+        /*!
+         * \return Histogram where every bin is the sum of the bins up to it (inclusive).
+         */
+        Histogram GetCumulative() const;
+
+        /*!
+         * \return Mean bin.
+         */
+        double GetMean() const;
+
+        /*!
+         * \return First bin where at least Fraction of the pixels is counted (0.5 - median).
+         */
+        uint32_t GetPercentile(double Fraction) const;
+
+        /*!
+         * \return Otsu threshold: the last bin of the darker class, which maximizes between-class variance.
+         */
+        uint32_t GetOtsuThreshold() const;
+
+        /*!
+         * Multi-level Otsu: split bins into Classes classes maximizing between-class variance.
+         *
+         * Maximizing the variance is the same as maximizing sum of S^2 / P over the classes (S - sum of values,
+         * P - amount of pixels of the class). With prefix sums S^2 / P of any range of bins is O(1), so
+         * the best split is found by dynamic programming in O(Classes * Bins^2) without the Bins^2 table,
+         * i.e. bucket wide histograms (e.g. 1024 bins for Mono16) before.
+         * \return Classes - 1 thresholds: the last bins of the classes in ascending order.
+         */
+        std::vector<uint32_t> GetMultiOtsuThresholds(uint32_t Classes) const;
+
+        /*!
+         * Fill LUT of the histogram equalization (for 256 bins), see GrayImage::ApplyLUT().
+         */
+        void GetEqualizationLUT(uint8_t (&LUT)[256]) const;
+
+        /*!
+         * \return Amount of values of the unsigned type T (up to 16 bits).
+         */
+        template<typename T>
+        static uint32_t GetLevels();
+
+        /*!
+         * \return Shift which puts all values of T into Bins bins (power of two), 0 - one bin per value.
+         */
+        template<typename T>
+        static uint32_t GetShift(uint32_t Bins = 0);
+
+        /*!
+         * \return Last value which goes into Bin with Shift.
+         */
+        static uint64_t GetLastValue(uint32_t Bin, uint32_t Shift);
+    private:
+        template<typename Pixel>
+        void AccumulateRows(const GenericImage<Pixel> &Src, const GenericImage<PixelType::Mono8> *pMask,
+                            uint32_t Plant, uint32_t Shift);
+
+        template<typename T>
+        static uint32_t GetBin(T Value, uint32_t Shift, uint32_t Bins);
+
+        std::vector<uint64_t> m_Bins;
+    };
+
+// =======================================================
+
+    inline Histogram::Histogram(uint32_t Bins)
+    {
+        Create(Bins);
+    }
+
+    inline void Histogram::Create(uint32_t Bins)
+    {
+        assert(Bins > 0);
+        m_Bins.assign(Bins, 0);
+    }
+
+    inline void Histogram::Clear()
+    {
+        std::fill(m_Bins.begin(), m_Bins.end(), 0);
+    }
+
+    template<typename T>
+    uint32_t Histogram::GetBin(T Value, uint32_t Shift, uint32_t Bins)
+    {
+        if (!(Value > 0))
+        {
+            return 0;
+        }
+        uint64_t Bin = (uint64_t) Value >> Shift;
+        return (Bin < Bins) ? (uint32_t) Bin : Bins - 1;
+    }
+
+    template<typename Pixel>
+    void Histogram::AccumulateRows(const GenericImage<Pixel> &Src, const GenericImage<PixelType::Mono8> *pMask,
+                                   uint32_t Plant, uint32_t Shift)
+    {
+        typedef typename Pixel::Type Type;
+        static_assert(std::is_integral<Type>::value, "Histogram supports only integer images.");
+        assert(Plant < Pixel::Plants);
+        assert(pMask == nullptr || (pMask->GetWidth() == Src.GetWidth() && pMask->GetHeight() == Src.GetHeight()));
+        uint32_t W = Src.GetWidth();
+        uint32_t Bins = GetBins();
+        uint32_t Copies = (Bins <= 4096) ? 4 : 1;
+        std::mutex Mutex;
+        ParallelRows(Src, [&](uint32_t First, uint32_t Last, uint32_t)
+        {
+            std::vector<uint64_t> Local((size_t) Copies * Bins, 0);
+            for (uint32_t y = First; y < Last; ++y)
+            {
+                const Type *pSrc = *Src.GetRow(y) + Plant;
+                const uint8_t *pRowMask = (pMask != nullptr) ? *pMask->GetRow(y) : nullptr;
+                for (uint32_t x = 0; x < W; ++x)
+                {
+                    if (pRowMask == nullptr || pRowMask[x] != 0)
+                    {
+                        ++Local[(x & (Copies - 1)) * Bins + GetBin(pSrc[(size_t) x * Pixel::Plants], Shift, Bins)];
+                    }
+                }
+            }
+            std::lock_guard<std::mutex> Lock(Mutex);
+            for (uint32_t c = 0; c < Copies; ++c)
+            {
+                for (uint32_t i = 0; i < Bins; ++i)
+                {
+                    m_Bins[i] += Local[(size_t) c * Bins + i];
+                }
+            }
+        });
+    }
+
+    template<typename Pixel>
+    void Histogram::Accumulate(const GenericImage<Pixel> &Src, uint32_t Plant, uint32_t Shift)
+    {
+        AccumulateRows(Src, nullptr, Plant, Shift);
+    }
+
+    template<typename Pixel>
+    void Histogram::Accumulate(const GenericImage<Pixel> &Src, const GenericImage<PixelType::Mono8> &Mask,
+                               uint32_t Plant, uint32_t Shift)
+    {
+        AccumulateRows(Src, &Mask, Plant, Shift);
+    }
+
+    template<typename Pixel>
+    void Histogram::Accumulate(const GenericImage<Pixel> &Src, const Rect<uint32_t> &Roi, uint32_t Plant,
+                               uint32_t Shift)
+    {
+        const ConstGenericImageView<Pixel> View(Src, Roi);
+        AccumulateRows(View.GetImage(), nullptr, Plant, Shift);
+    }
+
+    template<typename Pixel>
+    void Histogram::Calculate(const GenericImage<Pixel> &Src, uint32_t Plant, uint32_t Shift)
+    {
+        Clear();
+        Accumulate(Src, Plant, Shift);
+    }
+
+    template<typename Pixel>
+    void Histogram::Calculate(const GenericImage<Pixel> &Src, const GenericImage<PixelType::Mono8> &Mask,
+                              uint32_t Plant, uint32_t Shift)
+    {
+        Clear();
+        Accumulate(Src, Mask, Plant, Shift);
+    }
+
+    template<typename Pixel>
+    void Histogram::Calculate(const GenericImage<Pixel> &Src, const Rect<uint32_t> &Roi, uint32_t Plant,
+                              uint32_t Shift)
+    {
+        Clear();
+        Accumulate(Src, Roi, Plant, Shift);
+    }
+
+    inline uint32_t Histogram::GetBins() const
+    {
+        return (uint32_t) m_Bins.size();
+    }
+
+    inline uint64_t Histogram::operator[](uint32_t Bin) const
+    {
+        assert(Bin < GetBins());
+        return m_Bins[Bin];
+    }
+
+    inline const uint64_t *Histogram::GetData() const
+    {
+        return m_Bins.data();
+    }
+
+    inline uint64_t Histogram::GetTotal() const
+    {
+        uint64_t Total = 0;
+        for (uint64_t Count : m_Bins)
+        {
+            Total += Count;
+        }
+        return Total;
+    }
+
+    inline Histogram Histogram::GetCumulative() const
+    {
+        Histogram Cumulative(GetBins());
+        uint64_t Sum = 0;
+        for (uint32_t i = 0; i < GetBins(); ++i)
+        {
+            Sum += m_Bins[i];
+            Cumulative.m_Bins[i] = Sum;
+        }
+        return Cumulative;
+    }
+
+    inline double Histogram::GetMean() const
+    {
+        uint64_t Energy = 0;
+        uint64_t Sum = 0;
+        for (uint32_t i = 0; i < GetBins(); ++i)
+        {
+            Energy += i * m_Bins[i];
+            Sum += m_Bins[i];
+        }
+        return (Sum > 0) ? (double) Energy / Sum : 0;
+    }
+
+    inline uint32_t Histogram::GetPercentile(double Fraction) const
+    {
+        double Required = Fraction * GetTotal();
+        uint64_t Sum = 0;
+        for (uint32_t i = 0; i < GetBins(); ++i)
+        {
+            Sum += m_Bins[i];
+            if (Sum > 0 && Sum >= Required)
+            {
+                return i;
+            }
+        }
+        return GetBins() - 1;
+    }
+
+    inline uint32_t Histogram::GetOtsuThreshold() const
+    {
+        uint64_t Energy = 0;
+        uint64_t Sum = 0;
+        for (uint32_t i = 0; i < GetBins(); ++i)
+        {
+            Energy += i * m_Bins[i];
+            Sum += m_Bins[i];
+        }
+        uint64_t PartialEnergy = 0;
+        uint64_t PartialSum = 0;
+        uint32_t Threshold = 0;
+        double w1 = 0;
+        double a = 0;
+        double Sigma = 0;
+        double MaxSigma = -1;
+        for (uint32_t i = 0; i < GetBins(); ++i)
+        {
+            PartialEnergy += i * m_Bins[i];
+            PartialSum += m_Bins[i];
+            w1 = (double) PartialSum / Sum;
+            a = (double) PartialEnergy / PartialSum - (double) (Energy - PartialEnergy) / (Sum - PartialSum);
+            Sigma = w1 * (1 - w1) * a * a;
+            if (Sigma > MaxSigma)
+            {
+                MaxSigma = Sigma;
+                Threshold = i;
+            }
+        }
+        return Threshold;
+    }
+
+    inline std::vector<uint32_t> Histogram::GetMultiOtsuThresholds(uint32_t Classes) const
+    {
+        uint32_t Bins = GetBins();
+        assert(Classes >= 2 && Classes <= Bins);
+        std::vector<uint64_t> Count(Bins + 1, 0);
+        std::vector<uint64_t> Energy(Bins + 1, 0);
+        for (uint32_t i = 0; i < Bins; ++i)
+        {
+            Count[i + 1] = Count[i] + m_Bins[i];
+            Energy[i + 1] = Energy[i] + i * m_Bins[i];
+        }
+        // S^2 / P of the bins [First, Last]
+        auto Score = [&](uint32_t First, uint32_t Last) -> double
+        {
+            uint64_t P = Count[Last + 1] - Count[First];
+            double S = (double) (Energy[Last + 1] - Energy[First]);
+            return (P > 0) ? S * S / P : 0;
+        };
+        // Best[v] - best score of k classes in the bins [0, v], Start[k][v] - first bin of the last class
+        std::vector<double> Best(Bins);
+        std::vector<double> Next(Bins);
+        std::vector<std::vector<uint32_t>> Start(Classes, std::vector<uint32_t>(Bins, 0));
+        for (uint32_t v = 0; v < Bins; ++v)
+        {
+            Best[v] = Score(0, v);
+        }
+        for (uint32_t k = 1; k < Classes; ++k)
+        {
+            for (uint32_t v = k; v < Bins; ++v)
+            {
+                double BestScore = -1;
+                for (uint32_t u = k; u <= v; ++u)
+                {
+                    double Value = Best[u - 1] + Score(u, v);
+                    if (Value > BestScore)
+                    {
+                        BestScore = Value;
+                        Start[k][v] = u;
+                    }
+                }
+                Next[v] = BestScore;
+            }
+            Best.swap(Next);
+        }
+        std::vector<uint32_t> Thresholds(Classes - 1);
+        uint32_t Last = Bins - 1;
+        for (uint32_t k = Classes - 1; k > 0; --k)
+        {
+            Last = Start[k][Last] - 1;
+            Thresholds[k - 1] = Last;
+        }
+        return Thresholds;
+    }
+
+    template<typename T>
+    uint32_t Histogram::GetLevels()
+    {
+        static_assert(std::is_unsigned<T>::value && sizeof(T) <= 2, "Only unsigned types up to 16 bits.");
+        return 1u << (8 * sizeof(T));
+    }
+
+    template<typename T>
+    uint32_t Histogram::GetShift(uint32_t Bins)
+    {
+        uint32_t Shift = 0;
+        if (Bins > 0)
+        {
+            while ((GetLevels<T>() >> Shift) > Bins)
+            {
+                ++Shift;
+            }
+        }
+        return Shift;
+    }
+
+    inline uint64_t Histogram::GetLastValue(uint32_t Bin, uint32_t Shift)
+    {
+        return (((uint64_t) Bin + 1) << Shift) - 1;
+    }
+
+    inline void Histogram::GetEqualizationLUT(uint8_t (&LUT)[256]) const
+    {
+        assert(GetBins() == 256);
+        Histogram Cumulative = GetCumulative();
+        uint64_t Total = Cumulative[255];
+        uint64_t Min = 0;
+        for (uint32_t i = 0; i < 256 && Min == 0; ++i)
+        {
+            Min = Cumulative[i];
+        }
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            if (Total == Min)
+            {
+                LUT[i] = i;
+            }
+            else
+            {
+                uint64_t Count = (Cumulative[i] > Min) ? Cumulative[i] - Min : 0;
+                LUT[i] = (uint8_t) ((Count * 255 + (Total - Min) / 2) / (Total - Min));
+            }
+        }
+    }
+};
+#endif //JIMLIB_HISTOGRAM_HPP
@@ -0,0 +1,305 @@
+/*
+ *  jimlib -- generic image and-image algorithms library
+ *  Copyright (C) 2015 Alexey Titov
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty.  In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ *
+ *  Alexey Titov
+ *  alex.justes@gmail.com
+ *  https://github.com/alex-justes/jimlib
+ */
+
+#ifndef JIMLIB_IMAGEALLOCATOR_HPP
+#define JIMLIB_IMAGEALLOCATOR_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
+namespace jimlib
+{
+    /*!
+     * Source of the image buffers.
+     *
+     * Every GenericImage takes its buffers from an allocator, by default from the one returned by
+     * ImageAllocator::GetDefault() at the moment of the image construction. Setting a PoolAllocator
+     * as the default makes all temporary images of the algorithms reuse the buffers, so a pipeline
+     * running on every frame stops touching the heap after the first frames.
+     *
+     * Allocator counts all requests and the requests which went to the heap, so it can be verified.
+     */
+    class ImageAllocator
+    {
+    public:
+        ImageAllocator();
+        virtual ~ImageAllocator();
+
+        uint8_t *Allocate(size_t Size);
+        void Deallocate(uint8_t *pData, size_t Size);
+
+        /*!
+         * \return Amount of Allocate() calls.
+         */
+        uint64_t GetAllocations() const;
+
+        /*!
+         * \return Amount of Deallocate() calls.
+         */
+        uint64_t GetDeallocations() const;
+
+        /*!
+         * \return Amount of the buffers allocated from the heap.
+         */
+        uint64_t GetHeapAllocations() const;
+
+        /*!
+         * \return Amount of the buffers returned to the heap.
+         */
+        uint64_t GetHeapDeallocations() const;
+
+        void ResetCounters();
+
+        /*!
+         * \return Allocator used by the newly created images.
+         */
+        static ImageAllocator *GetDefault();
+
+        /*!
+         * Set allocator used by the newly created images. It should outlive them.
+         * \param[in] pAllocator Allocator, nullptr restores the heap allocator.
+         */
+        static void SetDefault(ImageAllocator *pAllocator);
+    protected:
+        virtual uint8_t *AllocateInternal(size_t Size) = 0;
+        virtual void DeallocateInternal(uint8_t *pData, size_t Size) = 0;
+        uint8_t *HeapAllocate(size_t Size);
+        void HeapDeallocate(uint8_t *pData);
+    private:
+        static ImageAllocator *HeapInstance();
+        static std::atomic<ImageAllocator *> &DefaultInstance();
+        std::atomic<uint64_t> m_Allocations;
+        std::atomic<uint64_t> m_Deallocations;
+        std::atomic<uint64_t> m_HeapAllocations;
+        std::atomic<uint64_t> m_HeapDeallocations;
+    };
+
+    /*!
+     * Plain new[]/delete[] allocator.
+     */
+    class HeapAllocator : public ImageAllocator
+    {
+    protected:
+        virtual uint8_t *AllocateInternal(size_t Size);
+        virtual void DeallocateInternal(uint8_t *pData, size_t Size);
+    };
+
+    /*!
+     * Size-bucketed pool of the buffers.
+     *
+     * Sizes are rounded up to the quarters of the power of two, released buffers are kept in the
+     * bucket and handed out to the next request of the same bucket. Thread-safe.
+     */
+    class PoolAllocator : public ImageAllocator
+    {
+    public:
+        virtual ~PoolAllocator();
+
+        /*!
+         * Return all cached buffers to the heap.
+         */
+        void Trim();
+
+        /*!
+         * \return Size in bytes of the cached buffers.
+         */
+        size_t GetCachedSize() const;
+
+        static size_t BucketSize(size_t Size);
+    protected:
+        virtual uint8_t *AllocateInternal(size_t Size);
+        virtual void DeallocateInternal(uint8_t *pData, size_t Size);
+    private:
+        typedef std::map<size_t, std::vector<uint8_t *>> Buckets;
+        mutable std::mutex m_Mutex;
+        Buckets m_Free;
+    };
+
+// =======================================================
+
+    inline ImageAllocator::ImageAllocator()
+            : m_Allocations(0),
+              m_Deallocations(0),
+              m_HeapAllocations(0),
+              m_HeapDeallocations(0)
+    { }
+
+    inline ImageAllocator::~ImageAllocator()
+    { }
+
+    inline uint8_t *ImageAllocator::Allocate(size_t Size)
+    {
+        ++m_Allocations;
+        return AllocateInternal(Size);
+    }
+
+    inline void ImageAllocator::Deallocate(uint8_t *pData, size_t Size)
+    {
+        ++m_Deallocations;
+        DeallocateInternal(pData, Size);
+    }
+
+    inline uint64_t ImageAllocator::GetAllocations() const
+    {
+        return m_Allocations;
+    }
+
+    inline uint64_t ImageAllocator::GetDeallocations() const
+    {
+        return m_Deallocations;
+    }
+
+    inline uint64_t ImageAllocator::GetHeapAllocations() const
+    {
+        return m_HeapAllocations;
+    }
+
+    inline uint64_t ImageAllocator::GetHeapDeallocations() const
+    {
+        return m_HeapDeallocations;
+    }
+
+    inline void ImageAllocator::ResetCounters()
+    {
+        m_Allocations = 0;
+        m_Deallocations = 0;
+        m_HeapAllocations = 0;
+        m_HeapDeallocations = 0;
+    }
+
+    inline uint8_t *ImageAllocator::HeapAllocate(size_t Size)
+    {
+        ++m_HeapAllocations;
+        return new uint8_t[Size];
+    }
+
+    inline void ImageAllocator::HeapDeallocate(uint8_t *pData)
+    {
+        ++m_HeapDeallocations;
+        delete[] pData;
+    }
+
+    inline ImageAllocator *ImageAllocator::HeapInstance()
+    {
+        static HeapAllocator Heap;
+        return &Heap;
+    }
+
+    inline std::atomic<ImageAllocator *> &ImageAllocator::DefaultInstance()
+    {
+        static std::atomic<ImageAllocator *> pDefault(HeapInstance());
+        return pDefault;
+    }
+
+    inline ImageAllocator *ImageAllocator::GetDefault()
+    {
+        return DefaultInstance();
+    }
+
+    inline void ImageAllocator::SetDefault(ImageAllocator *pAllocator)
+    {
+        DefaultInstance() = (pAllocator != nullptr) ? pAllocator : HeapInstance();
+    }
+
+    inline uint8_t *HeapAllocator::AllocateInternal(size_t Size)
+    {
+        return HeapAllocate(Size);
+    }
+
+    inline void HeapAllocator::DeallocateInternal(uint8_t *pData, size_t)
+    {
+        HeapDeallocate(pData);
+    }
+
+    inline PoolAllocator::~PoolAllocator()
+    {
+        Trim();
+    }
+
+    inline size_t PoolAllocator::BucketSize(size_t Size)
+    {
+        if (Size <= 64)
+        {
+            return 64;
+        }
+        size_t Pow = 64;
+        while (Pow <= Size / 2)
+        {
+            Pow *= 2;
+        }
+        size_t Step = Pow / 4;
+        return (Size + Step - 1) / Step * Step;
+    }
+
+    inline uint8_t *PoolAllocator::AllocateInternal(size_t Size)
+    {
+        size_t Bucket = BucketSize(Size);
+        {
+            std::lock_guard<std::mutex> Lock(m_Mutex);
+            Buckets::iterator it = m_Free.find(Bucket);
+            if (it != m_Free.end() && !it->second.empty())
+            {
+                uint8_t *pData = it->second.back();
+                it->second.pop_back();
+                return pData;
+            }
+        }
+        return HeapAllocate(Bucket);
+    }
+
+    inline void PoolAllocator::DeallocateInternal(uint8_t *pData, size_t Size)
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        m_Free[BucketSize(Size)].push_back(pData);
+    }
+
+    inline void PoolAllocator::Trim()
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        for (Buckets::iterator it = m_Free.begin(); it != m_Free.end(); ++it)
+        {
+            for (size_t i = 0; i < it->second.size(); ++i)
+            {
+                HeapDeallocate(it->second[i]);
+            }
+        }
+        m_Free.clear();
+    }
+
+    inline size_t PoolAllocator::GetCachedSize() const
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        size_t Size = 0;
+        for (Buckets::const_iterator it = m_Free.begin(); it != m_Free.end(); ++it)
+        {
+            Size += it->first * it->second.size();
+        }
+        return Size;
+    }
+};
+#endif //JIMLIB_IMAGEALLOCATOR_HPP
@@ -0,0 +1,160 @@
+/*
+ *  jimlib -- generic image and-image algorithms library
+ *  Copyright (C) 2015 Alexey Titov
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty.  In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ *
+ *  Alexey Titov
+ *  alex.justes@gmail.com
+ *  https://github.com/alex-justes/jimlib
+ */
+
+#ifndef JIMLIB_IMAGEBAND_HPP
+#define JIMLIB_IMAGEBAND_HPP
+
+#include <cstring>
+#include "Image/GenericImage.hpp"
+namespace jimlib
+{
+    /*!
+     * Source of the image rows for the banded (streaming) processing.
+     *
+     * Images which don't fit into memory (i.e. stitched mosaics) are processed by horizontal bands
+     * of full width, so only a few rows are kept in memory at once. Implement it on top of your own IO.
+     */
+    template<typename Pixel>
+    class BandReader
+    {
+    public:
+        virtual ~BandReader() {}
+
+        /*!
+         * \return Width of the whole image.
+         */
+        virtual uint32_t GetWidth() const = 0;
+
+        /*!
+         * \return Height of the whole image.
+         */
+        virtual uint32_t GetHeight() const = 0;
+
+        /*!
+         * Fill the Band with rows [FirstRow, FirstRow + Band.GetHeight()).
+         * Band is already created with GetWidth() columns. The same rows can be requested more than once.
+         * \param[in] FirstRow First row of the band
+         * \param[out] Band Destination band
+         */
+        virtual void Read(uint32_t FirstRow, GenericImage<Pixel> &Band) = 0;
+    };
+
+    /*!
+     * Consumer of the bands produced by the banded processing. Bands are written from top to bottom.
+     */
+    template<typename Pixel>
+    class BandWriter
+    {
+    public:
+        virtual ~BandWriter() {}
+
+        /*!
+         * Store the Band as rows [FirstRow, FirstRow + Band.GetHeight()) of the result.
+         * \param[in] FirstRow First row of the band
+         * \param[in] Band Processed band
+         */
+        virtual void Write(uint32_t FirstRow, const GenericImage<Pixel> &Band) = 0;
+    };
+
+    /*!
+     * BandReader over the in-memory image.
+     */
+    template<typename Pixel>
+    class ImageBandReader : public BandReader<Pixel>
+    {
+    public:
+        ImageBandReader(const GenericImage<Pixel> &Image);
+        uint32_t GetWidth() const;
+        uint32_t GetHeight() const;
+        void Read(uint32_t FirstRow, GenericImage<Pixel> &Band);
+    private:
+        const GenericImage<Pixel> &m_Image;
+    };
+
+    /*!
+     * BandWriter into the in-memory image, Image is created with the given size.
+     */
+    template<typename Pixel>
+    class ImageBandWriter : public BandWriter<Pixel>
+    {
+    public:
+        ImageBandWriter(GenericImage<Pixel> &Image, uint32_t Width, uint32_t Height);
+        void Write(uint32_t FirstRow, const GenericImage<Pixel> &Band);
+    private:
+        GenericImage<Pixel> &m_Image;
+    };
+
+// =======================================================
+
+    template<typename Pixel>
+    ImageBandReader<Pixel>::ImageBandReader(const GenericImage<Pixel> &Image)
+            : m_Image(Image)
+    {
+    }
+
+    template<typename Pixel>
+    uint32_t ImageBandReader<Pixel>::GetWidth() const
+    {
+        return m_Image.GetWidth();
+    }
+
+    template<typename Pixel>
+    uint32_t ImageBandReader<Pixel>::GetHeight() const
+    {
+        return m_Image.GetHeight();
+    }
+
+    template<typename Pixel>
+    void ImageBandReader<Pixel>::Read(uint32_t FirstRow, GenericImage<Pixel> &Band)
+    {
+        assert(Band.GetWidth() == m_Image.GetWidth());
+        assert(FirstRow + Band.GetHeight() <= m_Image.GetHeight());
+        size_t RowSize = (size_t)Band.GetWidth() * GenericImage<Pixel>::SizeOfPixel;
+        for (uint32_t y = 0; y < Band.GetHeight(); ++y)
+        {
+            memcpy(*Band.GetRow(y), *m_Image.GetRow(FirstRow + y), RowSize);
+        }
+    }
+
+    template<typename Pixel>
+    ImageBandWriter<Pixel>::ImageBandWriter(GenericImage<Pixel> &Image, uint32_t Width, uint32_t Height)
+            : m_Image(Image)
+    {
+        m_Image.Create(Width, Height);
+    }
+
+    template<typename Pixel>
+    void ImageBandWriter<Pixel>::Write(uint32_t FirstRow, const GenericImage<Pixel> &Band)
+    {
+        assert(Band.GetWidth() == m_Image.GetWidth());
+        assert(FirstRow + Band.GetHeight() <= m_Image.GetHeight());
+        size_t RowSize = (size_t)Band.GetWidth() * GenericImage<Pixel>::SizeOfPixel;
+        for (uint32_t y = 0; y < Band.GetHeight(); ++y)
+        {
+            memcpy(*m_Image.GetRow(FirstRow + y), *Band.GetRow(y), RowSize);
+        }
+    }
+};
+#endif //JIMLIB_IMAGEBAND_HPP
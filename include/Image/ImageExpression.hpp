@@ -0,0 +1,460 @@
+/*
+ *  jimlib -- generic image and-image algorithms library
+ *  Copyright (C) 2015 Alexey Titov
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty.  In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ *
+ *  Alexey Titov
+ *  alex.justes@gmail.com
+ *  https://github.com/alex-justes/jimlib
+ */
+
+#ifndef JIMLIB_IMAGEEXPRESSION_HPP
+#define JIMLIB_IMAGEEXPRESSION_HPP
+
+#include <cmath>
+#include <cstdlib>
+#include <type_traits>
+#include <utility>
+#include "Image/GenericImage.hpp"
+#include "Utils/ThreadPool.hpp"
+namespace jimlib
+{
+    /*!
+     * Lazy pixel-wise expressions over images.
+     *
+     * Arithmetic (+ - * /), comparisons (< > <= >= == !=) and the functions below applied to images,
+     * expressions and scalars don't calculate anything, they build a small tree of nodes.
+     * Evaluate(Dst, Expression) walks over Dst row by row (in parallel) and calculates the whole tree
+     * per element in one pass, so there are no temporary images and simple trees are auto-vectorized.
+     * \code
+     * Evaluate(Dst, Clamp(Cast<int32_t>(k * Src + b), 0, 255));
+     * Evaluate(Magnitude, Abs(Gx) + Abs(Gy));
+     * Evaluate(Mask, Gray > 128); // BinaryImage gets 0/1
+     * \endcode
+     * Values are calculated with the usual C++ promotions of the operand types and are converted to
+     * the type of Dst at the end. All images of the expression should have the same size and plants,
+     * Dst could be one of them.
+     */
+    template<typename Derived>
+    class ImageExpression
+    {
+    public:
+        const Derived &Self() const
+        { return static_cast<const Derived &>(*this); }
+    };
+
+    /*!
+     * Leaf node: elements of the image.
+     */
+    template<typename Pixel>
+    class ImageTerm : public ImageExpression<ImageTerm<Pixel>>
+    {
+    public:
+        typedef typename Pixel::Type Type;
+        static const uint32_t Plants = Pixel::Plants;
+        class Row
+        {
+        public:
+            Row(const Type *pRow) : m_pRow(pRow)
+            { }
+            Type operator[](size_t i) const
+            { return m_pRow[i]; }
+        private:
+            const Type *m_pRow;
+        };
+        explicit ImageTerm(const GenericImage<Pixel> &Image) : m_Image(Image)
+        { }
+        uint32_t GetWidth() const
+        { return m_Image.GetWidth(); }
+        uint32_t GetHeight() const
+        { return m_Image.GetHeight(); }
+        Row GetRow(uint32_t y) const
+        { return Row(*m_Image.GetRow(y)); }
+    private:
+        const GenericImage<Pixel> &m_Image;
+    };
+
+    /*!
+     * Leaf node: the same value for every element (size and plants are taken from the other operand).
+     */
+    template<typename T>
+    class ScalarTerm : public ImageExpression<ScalarTerm<T>>
+    {
+    public:
+        typedef T Type;
+        static const uint32_t Plants = 0;
+        class Row
+        {
+        public:
+            Row(T Value) : m_Value(Value)
+            { }
+            T operator[](size_t) const
+            { return m_Value; }
+        private:
+            T m_Value;
+        };
+        explicit ScalarTerm(T Value) : m_Value(Value)
+        { }
+        uint32_t GetWidth() const
+        { return 0; }
+        uint32_t GetHeight() const
+        { return 0; }
+        Row GetRow(uint32_t) const
+        { return Row(m_Value); }
+    private:
+        T m_Value;
+    };
+
+    template<typename Op, typename Arg>
+    class UnaryExpression : public ImageExpression<UnaryExpression<Op, Arg>>
+    {
+    public:
+        typedef decltype(Op()(std::declval<typename Arg::Type>())) Type;
+        static const uint32_t Plants = Arg::Plants;
+        class Row
+        {
+        public:
+            Row(const typename Arg::Row &Value) : m_Arg(Value)
+            { }
+            Type operator[](size_t i) const
+            { return Op()(m_Arg[i]); }
+        private:
+            typename Arg::Row m_Arg;
+        };
+        explicit UnaryExpression(const Arg &Value) : m_Arg(Value)
+        { }
+        uint32_t GetWidth() const
+        { return m_Arg.GetWidth(); }
+        uint32_t GetHeight() const
+        { return m_Arg.GetHeight(); }
+        Row GetRow(uint32_t y) const
+        { return Row(m_Arg.GetRow(y)); }
+    private:
+        Arg m_Arg;
+    };
+
+    template<typename Op, typename Left, typename Right>
+    class BinaryExpression : public ImageExpression<BinaryExpression<Op, Left, Right>>
+    {
+        static_assert(Left::Plants == Right::Plants || Left::Plants == 0 || Right::Plants == 0,
+                      "Operands should have the same amount of plants!");
+    public:
+        typedef decltype(Op()(std::declval<typename Left::Type>(), std::declval<typename Right::Type>())) Type;
+        static const uint32_t Plants = (Left::Plants != 0) ? Left::Plants : Right::Plants;
+        class Row
+        {
+        public:
+            Row(const typename Left::Row &L, const typename Right::Row &R) : m_Left(L), m_Right(R)
+            { }
+            Type operator[](size_t i) const
+            { return Op()(m_Left[i], m_Right[i]); }
+        private:
+            typename Left::Row m_Left;
+            typename Right::Row m_Right;
+        };
+        BinaryExpression(const Left &L, const Right &R) : m_Left(L), m_Right(R)
+        {
+            assert(L.GetWidth() == 0 || R.GetWidth() == 0 || L.GetWidth() == R.GetWidth());
+            assert(L.GetHeight() == 0 || R.GetHeight() == 0 || L.GetHeight() == R.GetHeight());
+        }
+        uint32_t GetWidth() const
+        { return (m_Left.GetWidth() != 0) ? m_Left.GetWidth() : m_Right.GetWidth(); }
+        uint32_t GetHeight() const
+        { return (m_Left.GetHeight() != 0) ? m_Left.GetHeight() : m_Right.GetHeight(); }
+        Row GetRow(uint32_t y) const
+        { return Row(m_Left.GetRow(y), m_Right.GetRow(y)); }
+    private:
+        Left m_Left;
+        Right m_Right;
+    };
+
+    template<typename Condition, typename Left, typename Right>
+    class SelectExpression : public ImageExpression<SelectExpression<Condition, Left, Right>>
+    {
+    public:
+        typedef typename std::common_type<typename Left::Type, typename Right::Type>::type Type;
+        static const uint32_t Plants = (Condition::Plants != 0) ? Condition::Plants :
+                                       (Left::Plants != 0) ? Left::Plants : Right::Plants;
+        class Row
+        {
+        public:
+            Row(const typename Condition::Row &C, const typename Left::Row &L, const typename Right::Row &R)
+                    : m_Condition(C), m_Left(L), m_Right(R)
+            { }
+            Type operator[](size_t i) const
+            { return m_Condition[i] ? (Type) m_Left[i] : (Type) m_Right[i]; }
+        private:
+            typename Condition::Row m_Condition;
+            typename Left::Row m_Left;
+            typename Right::Row m_Right;
+        };
+        SelectExpression(const Condition &C, const Left &L, const Right &R) : m_Condition(C), m_Left(L), m_Right(R)
+        { }
+        uint32_t GetWidth() const
+        {
+            return (m_Condition.GetWidth() != 0) ? m_Condition.GetWidth() :
+                   (m_Left.GetWidth() != 0) ? m_Left.GetWidth() : m_Right.GetWidth();
+        }
+        uint32_t GetHeight() const
+        {
+            return (m_Condition.GetHeight() != 0) ? m_Condition.GetHeight() :
+                   (m_Left.GetHeight() != 0) ? m_Left.GetHeight() : m_Right.GetHeight();
+        }
+        Row GetRow(uint32_t y) const
+        { return Row(m_Condition.GetRow(y), m_Left.GetRow(y), m_Right.GetRow(y)); }
+    private:
+        Condition m_Condition;
+        Left m_Left;
+        Right m_Right;
+    };
+
+    /*!
+     * Element operations of the expression nodes.
+     */
+    namespace ExpressionOp
+    {
+#define JIMLIB_EXPRESSION_BINARY_OP(Name, Op) \
+        struct Name \
+        { \
+            template<typename A, typename B> \
+            auto operator()(A a, B b) const -> decltype(a Op b) \
+            { return a Op b; } \
+        };
+        JIMLIB_EXPRESSION_BINARY_OP(Add, +)
+        JIMLIB_EXPRESSION_BINARY_OP(Sub, -)
+        JIMLIB_EXPRESSION_BINARY_OP(Mul, *)
+        JIMLIB_EXPRESSION_BINARY_OP(Div, /)
+        JIMLIB_EXPRESSION_BINARY_OP(Less, <)
+        JIMLIB_EXPRESSION_BINARY_OP(Greater, >)
+        JIMLIB_EXPRESSION_BINARY_OP(LessEqual, <=)
+        JIMLIB_EXPRESSION_BINARY_OP(GreaterEqual, >=)
+        JIMLIB_EXPRESSION_BINARY_OP(Equal, ==)
+        JIMLIB_EXPRESSION_BINARY_OP(NotEqual, !=)
+#undef JIMLIB_EXPRESSION_BINARY_OP
+        struct Min
+        {
+            template<typename A, typename B>
+            auto operator()(A a, B b) const -> typename std::decay<decltype(a < b ? a : b)>::type
+            { return a < b ? a : b; }
+        };
+        struct Max
+        {
+            template<typename A, typename B>
+            auto operator()(A a, B b) const -> typename std::decay<decltype(a > b ? a : b)>::type
+            { return a > b ? a : b; }
+        };
+        struct Negate
+        {
+            template<typename A>
+            auto operator()(A a) const -> decltype(-a)
+            { return -a; }
+        };
+        struct Abs
+        {
+            template<typename A>
+            auto operator()(A a) const -> decltype(a < 0 ? -a : a)
+            { return a < 0 ? -a : a; }
+        };
+        struct Sqrt
+        {
+            template<typename A>
+            auto operator()(A a) const -> decltype(std::sqrt(a))
+            { return std::sqrt(a); }
+        };
+        struct Round
+        {
+            template<typename A>
+            auto operator()(A a) const -> decltype(std::round(a))
+            { return std::round(a); }
+        };
+        template<typename T>
+        struct Cast
+        {
+            template<typename A>
+            T operator()(A a) const
+            { return static_cast<T>(a); }
+        };
+    };
+
+    namespace ExpressionDetail
+    {
+        template<typename Pixel>
+        ImageTerm<Pixel> Term(const GenericImage<Pixel> &Image)
+        { return ImageTerm<Pixel>(Image); }
+
+        template<typename Derived>
+        const Derived &Term(const ImageExpression<Derived> &Expression)
+        { return Expression.Self(); }
+
+        template<typename T>
+        typename std::enable_if<std::is_arithmetic<T>::value, ScalarTerm<T>>::type Term(T Value)
+        { return ScalarTerm<T>(Value); }
+
+        /*!
+         * Node type for the operand: image, expression or scalar.
+         */
+        template<typename T>
+        struct TermOf
+        {
+            typedef typename std::decay<decltype(Term(std::declval<const T &>()))>::type Type;
+        };
+
+        /*!
+         * Defined only if at least one of the operands is image or expression, so the
+         * operators don't hijack anything else.
+         */
+        template<typename Op, typename L, typename R, typename = void>
+        struct Binary
+        { };
+
+        template<typename Op, typename L, typename R>
+        struct Binary<Op, L, R, typename std::enable_if<
+                !(std::is_arithmetic<L>::value && std::is_arithmetic<R>::value),
+                decltype(void(Term(std::declval<const L &>())), void(Term(std::declval<const R &>())))>::type>
+        {
+            typedef BinaryExpression<Op, typename TermOf<L>::Type, typename TermOf<R>::Type> Type;
+            static Type Make(const L &Left, const R &Right)
+            { return Type(Term(Left), Term(Right)); }
+        };
+
+        template<typename Op, typename A, typename = void>
+        struct Unary
+        { };
+
+        template<typename Op, typename A>
+        struct Unary<Op, A, typename std::enable_if<!std::is_arithmetic<A>::value,
+                decltype(void(Term(std::declval<const A &>())))>::type>
+        {
+            typedef UnaryExpression<Op, typename TermOf<A>::Type> Type;
+            static Type Make(const A &Arg)
+            { return Type(Term(Arg)); }
+        };
+    };
+
+#define JIMLIB_EXPRESSION_OPERATOR(Name, Op) \
+    template<typename L, typename R> \
+    typename ExpressionDetail::Binary<ExpressionOp::Name, L, R>::Type operator Op(const L &Left, const R &Right) \
+    { return ExpressionDetail::Binary<ExpressionOp::Name, L, R>::Make(Left, Right); }
+    JIMLIB_EXPRESSION_OPERATOR(Add, +)
+    JIMLIB_EXPRESSION_OPERATOR(Sub, -)
+    JIMLIB_EXPRESSION_OPERATOR(Mul, *)
+    JIMLIB_EXPRESSION_OPERATOR(Div, /)
+    JIMLIB_EXPRESSION_OPERATOR(Less, <)
+    JIMLIB_EXPRESSION_OPERATOR(Greater, >)
+    JIMLIB_EXPRESSION_OPERATOR(LessEqual, <=)
+    JIMLIB_EXPRESSION_OPERATOR(GreaterEqual, >=)
+    JIMLIB_EXPRESSION_OPERATOR(Equal, ==)
+    JIMLIB_EXPRESSION_OPERATOR(NotEqual, !=)
+#undef JIMLIB_EXPRESSION_OPERATOR
+
+    template<typename A>
+    typename ExpressionDetail::Unary<ExpressionOp::Negate, A>::Type operator-(const A &Arg)
+    { return ExpressionDetail::Unary<ExpressionOp::Negate, A>::Make(Arg); }
+
+    /*!
+     * \return Element-wise absolute value.
+     */
+    template<typename A>
+    typename ExpressionDetail::Unary<ExpressionOp::Abs, A>::Type Abs(const A &Arg)
+    { return ExpressionDetail::Unary<ExpressionOp::Abs, A>::Make(Arg); }
+
+    /*!
+     * \return Element-wise square root (std::sqrt, i.e. double for integer elements).
+     */
+    template<typename A>
+    typename ExpressionDetail::Unary<ExpressionOp::Sqrt, A>::Type Sqrt(const A &Arg)
+    { return ExpressionDetail::Unary<ExpressionOp::Sqrt, A>::Make(Arg); }
+
+    /*!
+     * \return Element-wise rounding to the nearest integer, halves away from zero (std::round).
+     */
+    template<typename A>
+    typename ExpressionDetail::Unary<ExpressionOp::Round, A>::Type Round(const A &Arg)
+    { return ExpressionDetail::Unary<ExpressionOp::Round, A>::Make(Arg); }
+
+    /*!
+     * \return Elements converted to T (as static_cast, i.e. truncation for floating point values).
+     */
+    template<typename T, typename A>
+    typename ExpressionDetail::Unary<ExpressionOp::Cast<T>, A>::Type Cast(const A &Arg)
+    { return ExpressionDetail::Unary<ExpressionOp::Cast<T>, A>::Make(Arg); }
+
+    /*!
+     * \return Element-wise minimum.
+     */
+    template<typename L, typename R>
+    typename ExpressionDetail::Binary<ExpressionOp::Min, L, R>::Type Min(const L &Left, const R &Right)
+    { return ExpressionDetail::Binary<ExpressionOp::Min, L, R>::Make(Left, Right); }
+
+    /*!
+     * \return Element-wise maximum.
+     */
+    template<typename L, typename R>
+    typename ExpressionDetail::Binary<ExpressionOp::Max, L, R>::Type Max(const L &Left, const R &Right)
+    { return ExpressionDetail::Binary<ExpressionOp::Max, L, R>::Make(Left, Right); }
+
+    /*!
+     * \return Arg clamped to [Low, High].
+     */
+    template<typename A, typename T>
+    auto Clamp(const A &Arg, T Low, T High) -> decltype(Min(Max(Arg, Low), High))
+    { return Min(Max(Arg, Low), High); }
+
+    /*!
+     * \return Element of Left where Condition is non-zero, element of Right otherwise.
+     */
+    template<typename C, typename L, typename R>
+    SelectExpression<typename ExpressionDetail::TermOf<C>::Type, typename ExpressionDetail::TermOf<L>::Type,
+            typename ExpressionDetail::TermOf<R>::Type> Select(const C &Condition, const L &Left, const R &Right)
+    {
+        using ExpressionDetail::Term;
+        return SelectExpression<typename ExpressionDetail::TermOf<C>::Type, typename ExpressionDetail::TermOf<L>::Type,
+                typename ExpressionDetail::TermOf<R>::Type>(Term(Condition), Term(Left), Term(Right));
+    }
+
+    /*!
+     * Calculate Expression for every element and store it to Dst (converted to the type of Dst).
+     * Dst is resized to the size of the Expression if needed, it could be an operand of the Expression.
+     */
+    template<typename Pixel, typename Derived>
+    void Evaluate(GenericImage<Pixel> &Dst, const ImageExpression<Derived> &Expression)
+    {
+        static_assert(Derived::Plants == Pixel::Plants, "Expression and Dst should have the same amount of plants!");
+        const Derived &E = Expression.Self();
+        uint32_t W = E.GetWidth();
+        uint32_t H = E.GetHeight();
+        if (Dst.GetWidth() != W || Dst.GetHeight() != H)
+        {
+            Dst.Create(W, H);
+        }
+        size_t Elements = (size_t) W * Pixel::Plants;
+        ParallelRows(Dst, [&](uint32_t First, uint32_t Last, uint32_t)
+        {
+            for (uint32_t y = First; y < Last; ++y)
+            {
+                typename Pixel::Type *pDst = *Dst.GetRow(y);
+                const typename Derived::Row Row = E.GetRow(y);
+                for (size_t i = 0; i < Elements; ++i)
+                {
+                    pDst[i] = static_cast<typename Pixel::Type>(Row[i]);
+                }
+            }
+        });
+    }
+};
+#endif //JIMLIB_IMAGEEXPRESSION_HPP
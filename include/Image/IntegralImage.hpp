@@ -26,115 +26,308 @@
 #ifndef JIMLIB_INTEGRALIMAGE_HPP
 #define JIMLIB_INTEGRALIMAGE_HPP
 
+#include <algorithm>
+#include <limits>
+#include <type_traits>
 #include "Image/GenericImage.hpp"
+#include "Image/ImageBand.hpp"
 #include "Image/PixelTypes.hpp"
 #include "Utils/Rect.hpp"
 namespace jimlib
 {
-    class IntegralImage : public GenericImage<PixelType::Mono64>
+    /*!
+     * Integral image with the sums of SumPixel::Type (PixelType::Mono32 or PixelType::Mono64).
+     * Sums wrap around modulo 2^bits, so the sum over a rectangle is exact as long as the sum itself fits
+     * into the type even if the full sums of the image don't (see IsExact()).
+     */
+    template <typename SumPixel>
+    class GenericIntegralImage : public GenericImage<SumPixel>
     {
     public:
+        typedef typename SumPixel::Type SumType;
+        static_assert(std::is_unsigned<SumType>::value && sizeof(SumType) >= sizeof(uint32_t),
+                      "Integral image sums should be unsigned 32 or 64 bit.");
+
+        /*!
+         * \return true if the sums (or the squared sums if Squared) over any Area pixels of the image of Pixel
+         * are exact with SumType.
+         */
+        template <typename Pixel>
+        static bool IsExact(uint64_t Area, bool Squared);
+
         template <typename Pixel>
         void Calculate(const GenericImage <Pixel> &Src);
         template <typename Pixel>
         void CalculateSquared(const GenericImage <Pixel> &Src);
-        uint64_t GetSum(const Rect<int32_t> &rc) const;
-        uint64_t GetSumUnsafe(const Rect<int32_t> &rc) const;
-        uint64_t GetFullSumUnsafe(uint32_t x, uint32_t y) const;
+
+        /*!
+         * Banded version of Calculate() for images which don't fit into memory.
+         * Src is read by BandHeight rows and the integral image is passed to Dst band by band,
+         * so only one band is kept in memory (it is left in this image after the call).
+         * Result is the same as Calculate() over the whole image.
+         */
+        template <typename Pixel>
+        void Calculate(BandReader<Pixel> &Src, BandWriter<SumPixel> &Dst, uint32_t BandHeight = 256);
+
+        /*!
+         * Banded version of CalculateSquared(), see Calculate(BandReader, BandWriter, uint32_t).
+         */
+        template <typename Pixel>
+        void CalculateSquared(BandReader<Pixel> &Src, BandWriter<SumPixel> &Dst, uint32_t BandHeight = 256);
+        SumType GetSum(const Rect<int32_t> &rc) const;
+        SumType GetSumUnsafe(const Rect<int32_t> &rc) const;
+
+        /*!
+         * \return sum of [0, x]x[0, y], exact only if IsExact() for the (x + 1) * (y + 1) pixels.
+         */
+        SumType GetFullSumUnsafe(uint32_t x, uint32_t y) const;
     private:
-        uint64_t GetSum(int32_t x, int32_t y) const;
+        SumType GetSum(int32_t x, int32_t y) const;
+
+        /*!
+         * Calculate integral image of the Src rows on top of the pAbove row (nullptr for the first band).
+         */
+        template <bool Squared, typename Pixel>
+        void CalculateRows(const GenericImage<Pixel> &Src, const SumType *pAbove);
+
+        template <bool Squared, typename Pixel>
+        void CalculateBanded(BandReader<Pixel> &Src, BandWriter<SumPixel> &Dst, uint32_t BandHeight);
     };
 
+    typedef GenericIntegralImage<PixelType::Mono64> IntegralImage;
+    typedef GenericIntegralImage<PixelType::Mono32> IntegralImage32; //< Half the memory, see IsExact()
+
+    /*!
+     * Integral image of the values (plant 0) and their squares (plant 1) calculated in one pass.
+     * Both sums of the pixel are in the same cache line, so the window lookup of the mean and the variance
+     * touches half as many lines as two integral images.
+     * Sums wrap around as in GenericIntegralImage, both are exact if GenericIntegralImage::IsExact(Area, true).
+     */
+    template <typename SumPixel>
+    class GenericDualIntegralImage : public GenericImage<GenericPixel<typename SumPixel::Type, 2>>
+    {
+    public:
+        typedef typename SumPixel::Type SumType;
+        static_assert(std::is_unsigned<SumType>::value && sizeof(SumType) >= sizeof(uint32_t),
+                      "Integral image sums should be unsigned 32 or 64 bit.");
+
+        template <typename Pixel>
+        void Calculate(const GenericImage <Pixel> &Src);
+
+        /*!
+         * Sums over rc clipped by the image (as GenericIntegralImage::GetSum()).
+         */
+        void GetSums(const Rect<int32_t> &rc, SumType &Sum, SumType &SquaredSum) const;
+    private:
+        const SumType *GetSums(int32_t x, int32_t y) const;
+    };
+
+    typedef GenericDualIntegralImage<PixelType::Mono64> DualIntegralImage;
+    typedef GenericDualIntegralImage<PixelType::Mono32> DualIntegralImage32;
+
 // =======================================================
 
-    inline uint64_t IntegralImage::GetSum(int32_t x, int32_t y) const
+    template <typename SumPixel>
+    template <typename Pixel>
+    bool GenericIntegralImage<SumPixel>::IsExact(uint64_t Area, bool Squared)
+    {
+        static_assert(std::is_integral<typename Pixel::Type>::value, "Integral image supports only integer pixels.");
+        const uint64_t Max = std::numeric_limits<SumType>::max();
+        uint64_t Value = std::numeric_limits<typename Pixel::Type>::max();
+        if (Squared)
+        {
+            if (Value > Max / Value)
+                return false;
+            Value *= Value;
+        }
+        return Area <= Max / Value;
+    }
+
+    template <typename SumPixel>
+    typename GenericIntegralImage<SumPixel>::SumType GenericIntegralImage<SumPixel>::GetSum(int32_t x, int32_t y) const
     {
         if (x < 0 || y < 0)
             return 0;
-        x = ((uint32_t)x >= GetWidth()) ? (GetWidth() - 1) : x;
-        y = ((uint32_t)y >= GetHeight()) ? (GetHeight() - 1) : y;
-        return GetPixel(x, y, 0);
+        x = ((uint32_t)x >= this->GetWidth()) ? (this->GetWidth() - 1) : x;
+        y = ((uint32_t)y >= this->GetHeight()) ? (this->GetHeight() - 1) : y;
+        return this->GetPixel(x, y, 0);
     }
 
-    inline uint64_t IntegralImage::GetSum(const Rect<int32_t> &rc) const
+    template <typename SumPixel>
+    typename GenericIntegralImage<SumPixel>::SumType GenericIntegralImage<SumPixel>::GetSum(const Rect<int32_t> &rc) const
     {
-        uint64_t A = GetSum(rc.right, rc.bottom);
-        uint64_t B = GetSum(rc.left - 1, rc.top - 1);
-        uint64_t C = GetSum(rc.right, rc.top - 1);
-        uint64_t D = GetSum(rc.left - 1, rc.bottom);
-        return (A + B - C - D);
+        SumType A = GetSum(rc.right, rc.bottom);
+        SumType B = GetSum(rc.left - 1, rc.top - 1);
+        SumType C = GetSum(rc.right, rc.top - 1);
+        SumType D = GetSum(rc.left - 1, rc.bottom);
+        return (SumType)(A + B - C - D);
     }
 
-    inline uint64_t IntegralImage::GetSumUnsafe(const Rect<int32_t> &rc) const
+    template <typename SumPixel>
+    typename GenericIntegralImage<SumPixel>::SumType GenericIntegralImage<SumPixel>::GetSumUnsafe(const Rect<int32_t> &rc) const
     {
-        return (GetPixel(rc.right, rc.bottom, 0)
-                + GetPixel(rc.left - 1, rc.top - 1, 0)
-                - GetPixel(rc.right, rc.top - 1, 0)
-                - GetPixel(rc.left - 1, rc.bottom, 0)
+        return (SumType)(this->GetPixel(rc.right, rc.bottom, 0)
+                         + this->GetPixel(rc.left - 1, rc.top - 1, 0)
+                         - this->GetPixel(rc.right, rc.top - 1, 0)
+                         - this->GetPixel(rc.left - 1, rc.bottom, 0)
         );
     }
 
-    inline uint64_t IntegralImage::GetFullSumUnsafe(uint32_t x, uint32_t y) const
+    template <typename SumPixel>
+    typename GenericIntegralImage<SumPixel>::SumType GenericIntegralImage<SumPixel>::GetFullSumUnsafe(uint32_t x, uint32_t y) const
     {
-        return GetPixel(x, y, 0);
+        return this->GetPixel(x, y, 0);
     }
 
+    template <typename SumPixel>
     template <typename Pixel>
-    void IntegralImage::Calculate(const GenericImage<Pixel> &Src)
+    void GenericDualIntegralImage<SumPixel>::Calculate(const GenericImage<Pixel> &Src)
     {
+        static_assert(GenericImage<Pixel>::Plants == 1, "Integral image supports only images with 1 plant.");
         uint32_t W = Src.GetWidth();
         uint32_t H = Src.GetHeight();
-        Create(W, H);
-        typename GenericImage<Pixel>::const_iterator it_src = Src.begin();
-        IntegralImage::iterator it_dst = begin();
-        it_dst[0] = it_src[0];
-        ++it_dst;
-        ++it_src;
-        IntegralImage::iterator it_sum = begin();
-        for (uint32_t x = 1; x < W; ++x, ++it_dst, ++it_src, ++it_sum)
-        {
-            it_dst[0] = it_sum[0] + it_src[0];
-        }
-        it_sum = begin();
-
-        for (uint32_t y = 1; y < H; ++y)
+        this->Create(W, H);
+        const SumType *pAbove = nullptr;
+        for (uint32_t y = 0; y < H; ++y)
         {
-            uint32_t LocalSum = 0;
-            for (uint32_t x = 0; x < W; ++x, ++it_dst, ++it_src, ++it_sum)
+            const typename Pixel::Type *pSrc = *Src.GetRow(y);
+            SumType *pDst = *this->GetRow(y);
+            SumType Sum = 0;
+            SumType SquaredSum = 0;
+            if (pAbove == nullptr)
+            {
+                for (uint32_t x = 0; x < W; ++x)
+                {
+                    SumType Value = pSrc[x];
+                    Sum += Value;
+                    SquaredSum += Value * Value;
+                    pDst[2 * x] = Sum;
+                    pDst[2 * x + 1] = SquaredSum;
+                }
+            }
+            else
             {
-                LocalSum += it_src[0];
-                it_dst[0] = it_sum[0] + LocalSum;
+                for (uint32_t x = 0; x < W; ++x)
+                {
+                    SumType Value = pSrc[x];
+                    Sum += Value;
+                    SquaredSum += Value * Value;
+                    pDst[2 * x] = pAbove[2 * x] + Sum;
+                    pDst[2 * x + 1] = pAbove[2 * x + 1] + SquaredSum;
+                }
             }
+            pAbove = pDst;
         }
     }
+
+    template <typename SumPixel>
+    const typename GenericDualIntegralImage<SumPixel>::SumType *GenericDualIntegralImage<SumPixel>::GetSums(int32_t x, int32_t y) const
+    {
+        static const SumType Zero[2] = {0, 0};
+        if (x < 0 || y < 0)
+            return Zero;
+        x = ((uint32_t)x >= this->GetWidth()) ? (this->GetWidth() - 1) : x;
+        y = ((uint32_t)y >= this->GetHeight()) ? (this->GetHeight() - 1) : y;
+        return *this->GetColRow(x, y);
+    }
+
+    template <typename SumPixel>
+    void GenericDualIntegralImage<SumPixel>::GetSums(const Rect<int32_t> &rc, SumType &Sum, SumType &SquaredSum) const
+    {
+        const SumType *A = GetSums(rc.right, rc.bottom);
+        const SumType *B = GetSums(rc.left - 1, rc.top - 1);
+        const SumType *C = GetSums(rc.right, rc.top - 1);
+        const SumType *D = GetSums(rc.left - 1, rc.bottom);
+        Sum = A[0] + B[0] - C[0] - D[0];
+        SquaredSum = A[1] + B[1] - C[1] - D[1];
+    }
+
+    template <typename SumPixel>
+    template <typename Pixel>
+    void GenericIntegralImage<SumPixel>::Calculate(const GenericImage<Pixel> &Src)
+    {
+        CalculateRows<false>(Src, nullptr);
+    }
+
+    template <typename SumPixel>
+    template <typename Pixel>
+    void GenericIntegralImage<SumPixel>::CalculateSquared(const GenericImage<Pixel> &Src)
+    {
+        CalculateRows<true>(Src, nullptr);
+    }
+
+    template <typename SumPixel>
+    template <typename Pixel>
+    void GenericIntegralImage<SumPixel>::Calculate(BandReader<Pixel> &Src, BandWriter<SumPixel> &Dst, uint32_t BandHeight)
+    {
+        CalculateBanded<false>(Src, Dst, BandHeight);
+    }
+
+    template <typename SumPixel>
     template <typename Pixel>
-    void IntegralImage::CalculateSquared(const GenericImage<Pixel> &Src)
+    void GenericIntegralImage<SumPixel>::CalculateSquared(BandReader<Pixel> &Src, BandWriter<SumPixel> &Dst, uint32_t BandHeight)
+    {
+        CalculateBanded<true>(Src, Dst, BandHeight);
+    }
+
+    template <typename SumPixel>
+    template <bool Squared, typename Pixel>
+    void GenericIntegralImage<SumPixel>::CalculateRows(const GenericImage<Pixel> &Src, const SumType *pAbove)
     {
+        static_assert(GenericImage<Pixel>::Plants == 1, "Integral image supports only images with 1 plant.");
         uint32_t W = Src.GetWidth();
         uint32_t H = Src.GetHeight();
-        Create(W, H);
-        typename GenericImage<Pixel>::const_iterator it_src = Src.begin();
-        IntegralImage::iterator it_dst = begin();
-        it_dst[0] = it_src[0] * it_src[0];
-        ++it_dst;
-        ++it_src;
-        IntegralImage::iterator it_sum = begin();
-        for (uint32_t x = 1; x < W; ++x, ++it_dst, ++it_src, ++it_sum)
+        this->Create(W, H);
+        uint32_t y = 0;
+        if (pAbove == nullptr)
         {
-            it_dst[0] = it_sum[0] + it_src[0] * it_src[0];
+            const typename Pixel::Type *pSrc = *Src.GetRow(0);
+            SumType *pDst = *this->GetRow(0);
+            SumType LocalSum = 0;
+            for (uint32_t x = 0; x < W; ++x)
+            {
+                // Squares are taken in SumType: the promotion to int overflows for 16 bit values
+                SumType Value = pSrc[x];
+                LocalSum += Squared ? Value * Value : Value;
+                pDst[x] = LocalSum;
+            }
+            pAbove = pDst;
+            ++y;
         }
-        it_sum = begin();
-        for (uint32_t y = 1; y < H; ++y)
+        for (; y < H; ++y)
         {
-            uint32_t LocalSum = 0;
-            for (uint32_t x = 0; x < W; ++x, ++it_dst, ++it_src, ++it_sum)
+            const typename Pixel::Type *pSrc = *Src.GetRow(y);
+            SumType *pDst = *this->GetRow(y);
+            SumType LocalSum = 0;
+            for (uint32_t x = 0; x < W; ++x)
             {
-                LocalSum += (it_src[0] * it_src[0]);
-                it_dst[0] = it_sum[0] + LocalSum;
+                SumType Value = pSrc[x];
+                LocalSum += Squared ? Value * Value : Value;
+                pDst[x] = pAbove[x] + LocalSum;
             }
+            pAbove = pDst;
+        }
+    }
+
+    template <typename SumPixel>
+    template <bool Squared, typename Pixel>
+    void GenericIntegralImage<SumPixel>::CalculateBanded(BandReader<Pixel> &Src, BandWriter<SumPixel> &Dst, uint32_t BandHeight)
+    {
+        assert(BandHeight > 0);
+        uint32_t W = Src.GetWidth();
+        uint32_t H = Src.GetHeight();
+        GenericImage<Pixel> Band;
+        GenericImage<SumPixel> Above;
+        Above.Create(W, 1);
+        for (uint32_t y = 0; y < H; y += BandHeight)
+        {
+            Band.Create(W, std::min(BandHeight, H - y));
+            Src.Read(y, Band);
+            CalculateRows<Squared>(Band, (y == 0) ? nullptr : *Above.GetRow(0));
+            Dst.Write(y, *this);
+            memcpy(*Above.GetRow(0), *this->GetRow(this->GetHeight() - 1), (size_t)W * this->SizeOfPixel);
         }
     }
 };
 
 #endif //JIMLIB_INTEGRALIMAGE_HPP
-
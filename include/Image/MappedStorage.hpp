@@ -0,0 +1,361 @@
+/*
+ *  jimlib -- generic image and-image algorithms library
+ *  Copyright (C) 2015 Alexey Titov
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty.  In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ *
+ *  Alexey Titov
+ *  alex.justes@gmail.com
+ *  https://github.com/alex-justes/jimlib
+ */
+
+#ifndef JIMLIB_MAPPEDSTORAGE_HPP
+#define JIMLIB_MAPPEDSTORAGE_HPP
+
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include "Image/GenericImage.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define JIMLIB_HAS_MMAP 1
+#endif
+
+namespace jimlib
+{
+    namespace MapMode
+    {
+        const uint32_t ReadOnly = 0; //< Shared read-only mapping, only through ReadOnlyMappedImage
+        const uint32_t CopyOnWrite = 1; //< Changes are private to the process and never reach the file
+        const uint32_t WriteBack = 2; //< Changes are written back to the file (see MappedStorage::Sync())
+    };
+
+    namespace PlantFormat
+    {
+        const uint32_t Unsigned = 0; //< Unsigned integers
+        const uint32_t Signed = 1; //< Signed integers
+        const uint32_t Float = 2; //< Floating point numbers
+    };
+
+    /*!
+     * Header of the raw image file. All fields are in the native byte order,
+     * pixel data starts right after the header (HeaderSize bytes from the beginning of the file),
+     * rows are Offset bytes apart.
+     */
+    struct MappedImageHeader
+    {
+        char Magic[8]; //< "JIMLIMG" + '\0'
+        uint32_t Version; //< Format version
+        uint32_t Width; //< Width of the image
+        uint32_t Height; //< Height of the image
+        uint32_t Plants; //< Plants in the Pixel
+        uint32_t SizeOfPlant; //< Size of the Plant in bytes
+        uint32_t Format; //< One of PlantFormat
+        uint64_t Offset; //< Distance in bytes between two successive rows
+        uint8_t Padding[24]; //< Zero, pads the header to the cache line
+    };
+
+    template<typename Pixel>
+    class ReadOnlyMappedImage;
+
+    /*!
+     * Storage backend which maps raw image files (MappedImageHeader + rows) into the GenericImage.
+     *
+     * Opening costs nothing up front: pages are read lazily on the first access, and processes mapping
+     * the same file read-only share the page cache, so no copies are made. The mapping is adopted by the
+     * image (GenericImage::Adopt()) and unmapped when the image is destroyed or recreated with another size.
+     * Only available on POSIX systems, elsewhere every function returns false.
+     */
+    class MappedStorage
+    {
+    public:
+        static const uint32_t Version = 1; //< Current format version
+        static const uint32_t HeaderSize = sizeof(MappedImageHeader); //< Offset of the pixel data in the file
+
+        /*!
+         * Map existing image file into the Image.
+         * \param[in] FileName File to map
+         * \param[in] Mode MapMode::CopyOnWrite or MapMode::WriteBack (read-only mappings are opened into
+         * ReadOnlyMappedImage, so they can't be written by mistake)
+         * \param[out] Image Image to hold the mapping
+         * \return false if file can't be mapped or its header doesn't match the Pixel
+         */
+        template<typename Pixel>
+        static bool Open(const std::string &FileName, uint32_t Mode, GenericImage<Pixel> &Image);
+
+        /*!
+         * Map existing image file read-only (MapMode::ReadOnly), pages are shared with other processes.
+         */
+        template<typename Pixel>
+        static bool Open(const std::string &FileName, ReadOnlyMappedImage<Pixel> &Image);
+
+        /*!
+         * Create (or truncate) image file of WidthXHeight and map it in the WriteBack mode.
+         * Rows are padded to the Alignment, pixels are zero.
+         */
+        template<typename Pixel>
+        static bool Create(const std::string &FileName, uint32_t Width, uint32_t Height, GenericImage<Pixel> &Image,
+                           uint32_t Alignment = RowAlignment::CacheLine);
+
+        /*!
+         * Write Image into the file which can be mapped with Open() later (i.e. precomputed IntegralImage).
+         * Doesn't need mmap, so it works everywhere.
+         */
+        template<typename Pixel>
+        static bool Save(const std::string &FileName, const GenericImage<Pixel> &Image);
+
+        /*!
+         * Flush changes of the WriteBack mapping to the file.
+         * \param[in] Image Image created by Create() or opened with MapMode::WriteBack
+         */
+        template<typename Pixel>
+        static bool Sync(const GenericImage<Pixel> &Image);
+    private:
+        template<typename Pixel>
+        static bool OpenFile(const std::string &FileName, uint32_t Mode, GenericImage<Pixel> &Image);
+        template<typename T>
+        static uint32_t GetPlantFormat();
+        template<typename Pixel>
+        static void FillHeader(MappedImageHeader &Header, uint32_t Width, uint32_t Height, uint64_t Offset);
+        static bool Map(int File, size_t Length, uint32_t Mode, uint8_t *&pBase);
+    };
+
+    /*!
+     * Image file mapped read-only by MappedStorage::Open(). Pages of such mapping can't be written,
+     * so the image is available only as const.
+     */
+    template<typename Pixel>
+    class ReadOnlyMappedImage
+    {
+    public:
+        ReadOnlyMappedImage() = default;
+        ReadOnlyMappedImage(ReadOnlyMappedImage<Pixel> &&Image) = default;
+        ReadOnlyMappedImage<Pixel> &operator=(ReadOnlyMappedImage<Pixel> &&Image) = default;
+        ReadOnlyMappedImage(const ReadOnlyMappedImage<Pixel> &) = delete;
+        ReadOnlyMappedImage<Pixel> &operator=(const ReadOnlyMappedImage<Pixel> &) = delete;
+
+        /*!
+         * \return Mapped image (empty if nothing is mapped).
+         */
+        const GenericImage<Pixel> &GetImage() const;
+    private:
+        friend class MappedStorage;
+        GenericImage<Pixel> m_Image;
+    };
+
+// =======================================================
+
+    template<typename Pixel>
+    void MappedStorage::FillHeader(MappedImageHeader &Header, uint32_t Width, uint32_t Height, uint64_t Offset)
+    {
+        memset(&Header, 0, sizeof(Header));
+        memcpy(Header.Magic, "JIMLIMG", 8);
+        Header.Version = Version;
+        Header.Width = Width;
+        Header.Height = Height;
+        Header.Plants = Pixel::Plants;
+        Header.SizeOfPlant = sizeof(typename Pixel::Type);
+        Header.Format = GetPlantFormat<typename Pixel::Type>();
+        Header.Offset = Offset;
+    }
+
+    template<typename T>
+    uint32_t MappedStorage::GetPlantFormat()
+    {
+        return std::is_floating_point<T>::value ? PlantFormat::Float
+                                                : (std::is_signed<T>::value ? PlantFormat::Signed
+                                                                            : PlantFormat::Unsigned);
+    }
+
+    template<typename Pixel>
+    const GenericImage<Pixel> &ReadOnlyMappedImage<Pixel>::GetImage() const
+    {
+        return m_Image;
+    }
+
+    template<typename Pixel>
+    bool MappedStorage::Save(const std::string &FileName, const GenericImage<Pixel> &Image)
+    {
+        FILE *pFile = fopen(FileName.c_str(), "wb");
+        if (pFile == nullptr)
+        {
+            return false;
+        }
+        size_t RowSize = (size_t) Image.GetWidth() * GenericImage<Pixel>::SizeOfPixel;
+        MappedImageHeader Header;
+        FillHeader<Pixel>(Header, Image.GetWidth(), Image.GetHeight(), RowSize);
+        bool Ok = fwrite(&Header, sizeof(Header), 1, pFile) == 1;
+        for (uint32_t y = 0; Ok && y < Image.GetHeight(); ++y)
+        {
+            Ok = fwrite(*Image.GetRow(y), 1, RowSize, pFile) == RowSize;
+        }
+        return (fclose(pFile) == 0) && Ok;
+    }
+
+#ifdef JIMLIB_HAS_MMAP
+    inline bool MappedStorage::Map(int File, size_t Length, uint32_t Mode, uint8_t *&pBase)
+    {
+        int Protection = (Mode == MapMode::ReadOnly) ? PROT_READ : (PROT_READ | PROT_WRITE);
+        int Flags = (Mode == MapMode::CopyOnWrite) ? MAP_PRIVATE : MAP_SHARED;
+        void *pData = mmap(nullptr, Length, Protection, Flags, File, 0);
+        close(File);
+        if (pData == MAP_FAILED)
+        {
+            return false;
+        }
+        pBase = static_cast<uint8_t *>(pData);
+        return true;
+    }
+
+    template<typename Pixel>
+    bool MappedStorage::Open(const std::string &FileName, uint32_t Mode, GenericImage<Pixel> &Image)
+    {
+        assert(Mode == MapMode::CopyOnWrite || Mode == MapMode::WriteBack);
+        if (Mode != MapMode::CopyOnWrite && Mode != MapMode::WriteBack)
+        {
+            return false;
+        }
+        return OpenFile(FileName, Mode, Image);
+    }
+
+    template<typename Pixel>
+    bool MappedStorage::Open(const std::string &FileName, ReadOnlyMappedImage<Pixel> &Image)
+    {
+        return OpenFile(FileName, MapMode::ReadOnly, Image.m_Image);
+    }
+
+    template<typename Pixel>
+    bool MappedStorage::OpenFile(const std::string &FileName, uint32_t Mode, GenericImage<Pixel> &Image)
+    {
+        int File = open(FileName.c_str(), (Mode == MapMode::WriteBack) ? O_RDWR : O_RDONLY);
+        if (File < 0)
+        {
+            return false;
+        }
+        struct stat Info;
+        if (fstat(File, &Info) != 0 || (uint64_t) Info.st_size < HeaderSize)
+        {
+            close(File);
+            return false;
+        }
+        size_t Length = (size_t) Info.st_size;
+        uint8_t *pBase = nullptr;
+        if (!Map(File, Length, Mode, pBase))
+        {
+            return false;
+        }
+        MappedImageHeader Header;
+        memcpy(&Header, pBase, sizeof(Header));
+        size_t RowSize = (size_t) Header.Width * GenericImage<Pixel>::SizeOfPixel;
+        if (memcmp(Header.Magic, "JIMLIMG", 8) != 0 || Header.Version != Version
+            || Header.Plants != Pixel::Plants || Header.SizeOfPlant != sizeof(typename Pixel::Type)
+            || Header.Format != GetPlantFormat<typename Pixel::Type>()
+            || Header.Offset < RowSize
+            || (Header.Height != 0 && Header.Offset > (Length - HeaderSize) / Header.Height))
+        {
+            munmap(pBase, Length);
+            return false;
+        }
+        Image.Adopt(pBase + HeaderSize, Header.Width, Header.Height, (size_t) Header.Offset,
+                    [pBase, Length](uint8_t *) { munmap(pBase, Length); });
+        return true;
+    }
+
+    template<typename Pixel>
+    bool MappedStorage::Create(const std::string &FileName, uint32_t Width, uint32_t Height,
+                               GenericImage<Pixel> &Image, uint32_t Alignment)
+    {
+        assert(Alignment != 0 && (Alignment & (Alignment - 1)) == 0 && Alignment <= HeaderSize);
+        uint64_t RowSize = (uint64_t) Width * GenericImage<Pixel>::SizeOfPixel;
+        uint64_t Offset = (RowSize + Alignment - 1) / Alignment * Alignment;
+        uint64_t Length = HeaderSize + Offset * Height;
+        if (Length > (uint64_t) std::numeric_limits<off_t>::max() || Length > std::numeric_limits<size_t>::max())
+        {
+            return false;
+        }
+        int File = open(FileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (File < 0)
+        {
+            return false;
+        }
+        if (ftruncate(File, (off_t) Length) != 0)
+        {
+            close(File);
+            return false;
+        }
+        uint8_t *pBase = nullptr;
+        if (!Map(File, (size_t) Length, MapMode::WriteBack, pBase))
+        {
+            return false;
+        }
+        MappedImageHeader Header;
+        FillHeader<Pixel>(Header, Width, Height, Offset);
+        memcpy(pBase, &Header, sizeof(Header));
+        size_t MapLength = (size_t) Length;
+        Image.Adopt(pBase + HeaderSize, Width, Height, (size_t) Offset,
+                    [pBase, MapLength](uint8_t *) { munmap(pBase, MapLength); });
+        return true;
+    }
+
+    template<typename Pixel>
+    bool MappedStorage::Sync(const GenericImage<Pixel> &Image)
+    {
+        if (Image.GetSize() == 0)
+        {
+            return true;
+        }
+        uint8_t *pBase = const_cast<uint8_t *>(reinterpret_cast<const uint8_t *>(*Image.begin())) - HeaderSize;
+        return msync(pBase, HeaderSize + Image.GetSize(), MS_SYNC) == 0;
+    }
+#else
+    inline bool MappedStorage::Map(int, size_t, uint32_t, uint8_t *&)
+    {
+        return false;
+    }
+
+    template<typename Pixel>
+    bool MappedStorage::Open(const std::string &, uint32_t, GenericImage<Pixel> &)
+    {
+        return false;
+    }
+
+    template<typename Pixel>
+    bool MappedStorage::Open(const std::string &, ReadOnlyMappedImage<Pixel> &)
+    {
+        return false;
+    }
+
+    template<typename Pixel>
+    bool MappedStorage::Create(const std::string &, uint32_t, uint32_t, GenericImage<Pixel> &, uint32_t)
+    {
+        return false;
+    }
+
+    template<typename Pixel>
+    bool MappedStorage::Sync(const GenericImage<Pixel> &)
+    {
+        return false;
+    }
+#endif
+};
+#endif //JIMLIB_MAPPEDSTORAGE_HPP
@@ -0,0 +1,439 @@
+/*
+ *  jimlib -- generic image and-image algorithms library
+ *  Copyright (C) 2015 Alexey Titov
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty.  In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ *
+ *  Alexey Titov
+ *  alex.justes@gmail.com
+ *  https://github.com/alex-justes/jimlib
+ */
+
+#ifndef JIMLIB_PACKEDBINARYIMAGE_HPP
+#define JIMLIB_PACKEDBINARYIMAGE_HPP
+
+#include <cstring>
+#include "Image/BinaryImage.hpp"
+#include "Image/Histogram.hpp"
+namespace jimlib
+{
+    /*!
+     * Binary image with 1 bit per pixel.
+     *
+     * Every row is stored as GetWordsPerRow() 64-bit words, pixel x of the row is the bit (x % 64) of the
+     * word (x / 64). Bits after the Width in the last word of the row are always zero, so word-parallel
+     * operations (Invert, And, Or, Xor, GetArea) never have to check the row tail.
+     * BinaryImage (one byte per pixel) is converted with Pack() and Unpack().
+     */
+    class PackedBinaryImage
+    {
+    public:
+        typedef GenericPixel<uint64_t, 1> WordPixel; //< Storage of the 64 pixels
+        static const uint32_t BitsPerWord = 64; //< Pixels in the word
+
+        PackedBinaryImage();
+
+        /*!
+         * Allocate WidthXHeight image. Pixels are not initialized, bits after the Width are zero.
+         */
+        void Create(uint32_t Width, uint32_t Height);
+
+        /*!
+         * Allocate WidthXHeight image with all pixels set to Value (0 or 1).
+         */
+        void Create(uint32_t Width, uint32_t Height, uint8_t Value);
+
+        uint32_t GetWidth() const;
+        uint32_t GetHeight() const;
+        uint32_t GetWordsPerRow() const;
+
+        uint8_t GetPixel(uint32_t x, uint32_t y) const;
+        void SetPixel(uint32_t x, uint32_t y, uint8_t Value);
+
+        /*!
+         * \return Pointer to the first word of the Row.
+         */
+        uint64_t *GetRow(uint32_t Row);
+        const uint64_t *GetRow(uint32_t Row) const;
+
+        /*!
+         * \return Amount of pixels set to 1.
+         */
+        uint64_t GetArea() const;
+
+        void Invert();
+        void And(const PackedBinaryImage &Src);
+        void Or(const PackedBinaryImage &Src);
+        void Xor(const PackedBinaryImage &Src);
+
+        /*!
+         * Pack the byte image, every non-zero pixel becomes 1.
+         */
+        void Pack(const GenericImage<PixelType::Mono8> &Src);
+
+        /*!
+         * Unpack into the byte image (0 or 1 per pixel), i.e. BinaryImage.
+         */
+        void Unpack(GenericImage<PixelType::Mono8> &Dst) const;
+
+        /*!
+         * Same as BinaryImage ones, but the result is packed directly.
+         */
+        template <typename Pixel>
+        void ThresholdUp(const GenericImage<Pixel> &Src, typename Pixel::Type Threshold);
+        template <typename Pixel>
+        void ThresholdDown(const GenericImage<Pixel> &Src, typename Pixel::Type Threshold);
+        template <typename Pixel>
+        void Otsu(const GenericImage<Pixel> &Src, uint32_t Bins = 0);
+        template <typename Pixel>
+        void Niblack(const GenericImage<Pixel> &Src, uint32_t WindowSize, double K);
+        template <typename Pixel>
+        void Sauvola(const GenericImage<Pixel> &Src, uint32_t WindowSize, double K);
+        template <typename Pixel>
+        void BoxMean(const GenericImage<Pixel> &Src, uint32_t WindowSize, double K);
+    private:
+        /*!
+         * LocalThreshold() destination: rows are binarized into the byte buffer of the worker and packed at the End().
+         */
+        class PackedRowSink
+        {
+        public:
+            PackedRowSink(PackedBinaryImage &Dst);
+            uint8_t *Begin(uint32_t Row, uint32_t Worker);
+            void End(uint32_t Row, uint32_t Worker);
+        private:
+            PackedBinaryImage &m_Dst;
+            GenericImage<PixelType::Mono8> m_Rows; //< One row per worker
+        };
+
+        template <typename Pixel, typename Compare>
+        void Threshold(const GenericImage<Pixel> &Src, Compare IsSet);
+        static void PackRow(const uint8_t *pSrc, uint32_t Width, uint64_t *pDst);
+        static uint32_t PopCount(uint64_t Word);
+        uint64_t GetTailMask() const;
+
+        GenericImage<WordPixel> m_Words; //< GetWordsPerRow() X Height words
+        uint32_t m_Width; //< Width in pixels
+    };
+
+// =======================================================
+
+    inline PackedBinaryImage::PackedBinaryImage()
+            : m_Width(0)
+    {
+    }
+
+    inline void PackedBinaryImage::Create(uint32_t Width, uint32_t Height)
+    {
+        uint32_t Words = (uint32_t) (((uint64_t) Width + BitsPerWord - 1) / BitsPerWord);
+        m_Words.Create(Words, Height);
+        m_Width = Width;
+        if (Words != 0)
+        {
+            for (uint32_t y = 0; y < Height; ++y)
+            {
+                GetRow(y)[Words - 1] = 0;
+            }
+        }
+    }
+
+    inline void PackedBinaryImage::Create(uint32_t Width, uint32_t Height, uint8_t Value)
+    {
+        Create(Width, Height);
+        uint32_t Words = GetWordsPerRow();
+        uint64_t Tail = GetTailMask();
+        for (uint32_t y = 0; y < Height; ++y)
+        {
+            uint64_t *pRow = GetRow(y);
+            for (uint32_t i = 0; i < Words; ++i)
+            {
+                pRow[i] = Value ? ~0ull : 0;
+            }
+            if (Words != 0)
+            {
+                pRow[Words - 1] &= Tail;
+            }
+        }
+    }
+
+    inline uint32_t PackedBinaryImage::GetWidth() const
+    {
+        return m_Width;
+    }
+
+    inline uint32_t PackedBinaryImage::GetHeight() const
+    {
+        return m_Words.GetHeight();
+    }
+
+    inline uint32_t PackedBinaryImage::GetWordsPerRow() const
+    {
+        return m_Words.GetWidth();
+    }
+
+    inline uint8_t PackedBinaryImage::GetPixel(uint32_t x, uint32_t y) const
+    {
+        assert(x < m_Width);
+        return (GetRow(y)[x / BitsPerWord] >> (x % BitsPerWord)) & 1;
+    }
+
+    inline void PackedBinaryImage::SetPixel(uint32_t x, uint32_t y, uint8_t Value)
+    {
+        assert(x < m_Width);
+        uint64_t Bit = 1ull << (x % BitsPerWord);
+        uint64_t &Word = GetRow(y)[x / BitsPerWord];
+        Word = Value ? (Word | Bit) : (Word & ~Bit);
+    }
+
+    inline uint64_t *PackedBinaryImage::GetRow(uint32_t Row)
+    {
+        return *m_Words.GetRow(Row);
+    }
+
+    inline const uint64_t *PackedBinaryImage::GetRow(uint32_t Row) const
+    {
+        return *m_Words.GetRow(Row);
+    }
+
+    inline uint64_t PackedBinaryImage::GetTailMask() const
+    {
+        uint32_t Bits = m_Width % BitsPerWord;
+        return (Bits == 0) ? ~0ull : ((1ull << Bits) - 1);
+    }
+
+    inline uint32_t PackedBinaryImage::PopCount(uint64_t Word)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcountll(Word);
+#else
+        Word = Word - ((Word >> 1) & 0x5555555555555555ull);
+        Word = (Word & 0x3333333333333333ull) + ((Word >> 2) & 0x3333333333333333ull);
+        Word = (Word + (Word >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+        return (uint32_t) ((Word * 0x0101010101010101ull) >> 56);
+#endif
+    }
+
+    inline uint64_t PackedBinaryImage::GetArea() const
+    {
+        uint64_t Area = 0;
+        uint32_t Words = GetWordsPerRow();
+        for (uint32_t y = 0; y < GetHeight(); ++y)
+        {
+            const uint64_t *pRow = GetRow(y);
+            for (uint32_t i = 0; i < Words; ++i)
+            {
+                Area += PopCount(pRow[i]);
+            }
+        }
+        return Area;
+    }
+
+    inline void PackedBinaryImage::Invert()
+    {
+        uint32_t Words = GetWordsPerRow();
+        uint64_t Tail = GetTailMask();
+        for (uint32_t y = 0; y < GetHeight(); ++y)
+        {
+            uint64_t *pRow = GetRow(y);
+            for (uint32_t i = 0; i < Words; ++i)
+            {
+                pRow[i] = ~pRow[i];
+            }
+            if (Words != 0)
+            {
+                pRow[Words - 1] &= Tail;
+            }
+        }
+    }
+
+    inline void PackedBinaryImage::And(const PackedBinaryImage &Src)
+    {
+        assert(Src.GetWidth() == GetWidth() && Src.GetHeight() == GetHeight());
+        uint32_t Words = GetWordsPerRow();
+        for (uint32_t y = 0; y < GetHeight(); ++y)
+        {
+            uint64_t *pRow = GetRow(y);
+            const uint64_t *pSrc = Src.GetRow(y);
+            for (uint32_t i = 0; i < Words; ++i)
+            {
+                pRow[i] &= pSrc[i];
+            }
+        }
+    }
+
+    inline void PackedBinaryImage::Or(const PackedBinaryImage &Src)
+    {
+        assert(Src.GetWidth() == GetWidth() && Src.GetHeight() == GetHeight());
+        uint32_t Words = GetWordsPerRow();
+        for (uint32_t y = 0; y < GetHeight(); ++y)
+        {
+            uint64_t *pRow = GetRow(y);
+            const uint64_t *pSrc = Src.GetRow(y);
+            for (uint32_t i = 0; i < Words; ++i)
+            {
+                pRow[i] |= pSrc[i];
+            }
+        }
+    }
+
+    inline void PackedBinaryImage::Xor(const PackedBinaryImage &Src)
+    {
+        assert(Src.GetWidth() == GetWidth() && Src.GetHeight() == GetHeight());
+        uint32_t Words = GetWordsPerRow();
+        for (uint32_t y = 0; y < GetHeight(); ++y)
+        {
+            uint64_t *pRow = GetRow(y);
+            const uint64_t *pSrc = Src.GetRow(y);
+            for (uint32_t i = 0; i < Words; ++i)
+            {
+                pRow[i] ^= pSrc[i];
+            }
+        }
+    }
+
+    inline void PackedBinaryImage::PackRow(const uint8_t *pSrc, uint32_t Width, uint64_t *pDst)
+    {
+        uint32_t Full = Width / BitsPerWord;
+        for (uint32_t i = 0; i < Full; ++i, pSrc += BitsPerWord)
+        {
+            uint64_t Word = 0;
+            for (uint32_t b = 0; b < BitsPerWord; ++b)
+            {
+                Word |= (uint64_t) (pSrc[b] != 0) << b;
+            }
+            pDst[i] = Word;
+        }
+        uint32_t Rest = Width % BitsPerWord;
+        if (Rest != 0)
+        {
+            uint64_t Word = 0;
+            for (uint32_t b = 0; b < Rest; ++b)
+            {
+                Word |= (uint64_t) (pSrc[b] != 0) << b;
+            }
+            pDst[Full] = Word;
+        }
+    }
+
+    inline void PackedBinaryImage::Pack(const GenericImage<PixelType::Mono8> &Src)
+    {
+        Create(Src.GetWidth(), Src.GetHeight());
+        for (uint32_t y = 0; y < GetHeight(); ++y)
+        {
+            PackRow(*Src.GetRow(y), m_Width, GetRow(y));
+        }
+    }
+
+    inline void PackedBinaryImage::Unpack(GenericImage<PixelType::Mono8> &Dst) const
+    {
+        Dst.Create(m_Width, GetHeight());
+        for (uint32_t y = 0; y < GetHeight(); ++y)
+        {
+            const uint64_t *pSrc = GetRow(y);
+            uint8_t *pDst = *Dst.GetRow(y);
+            for (uint32_t x = 0; x < m_Width; ++x)
+            {
+                pDst[x] = (pSrc[x / BitsPerWord] >> (x % BitsPerWord)) & 1;
+            }
+        }
+    }
+
+    inline PackedBinaryImage::PackedRowSink::PackedRowSink(PackedBinaryImage &Dst)
+            : m_Dst(Dst)
+    {
+        m_Rows.Create(Dst.GetWidth(), ThreadPool::GetDefault()->GetWorkers());
+    }
+
+    inline uint8_t *PackedBinaryImage::PackedRowSink::Begin(uint32_t, uint32_t Worker)
+    {
+        return *m_Rows.GetRow(Worker);
+    }
+
+    inline void PackedBinaryImage::PackedRowSink::End(uint32_t Row, uint32_t Worker)
+    {
+        PackRow(*m_Rows.GetRow(Worker), m_Dst.GetWidth(), m_Dst.GetRow(Row));
+    }
+
+    template <typename Pixel, typename Compare>
+    void PackedBinaryImage::Threshold(const GenericImage<Pixel> &Src, Compare IsSet)
+    {
+        static_assert(GenericImage<Pixel>::Plants == 1, "Binary image supports only images with 1 plant.");
+        Create(Src.GetWidth(), Src.GetHeight());
+        ParallelRows(Src, [&](uint32_t First, uint32_t Last, uint32_t)
+        {
+            for (uint32_t y = First; y < Last; ++y)
+            {
+                typename GenericImage<Pixel>::const_iterator it_src = Src.GetRow(y);
+                uint64_t *pDst = GetRow(y);
+                for (uint32_t x = 0; x < m_Width; x += BitsPerWord)
+                {
+                    uint32_t Bits = (m_Width - x < BitsPerWord) ? (m_Width - x) : BitsPerWord;
+                    uint64_t Word = 0;
+                    for (uint32_t b = 0; b < Bits; ++b, ++it_src)
+                    {
+                        Word |= (uint64_t) IsSet(it_src[0]) << b;
+                    }
+                    pDst[x / BitsPerWord] = Word;
+                }
+            }
+        });
+    }
+
+    template <typename Pixel>
+    void PackedBinaryImage::ThresholdUp(const GenericImage<Pixel> &Src, typename Pixel::Type Threshold)
+    {
+        this->Threshold(Src, [Threshold](typename Pixel::Type Value) { return Value > Threshold; });
+    }
+
+    template <typename Pixel>
+    void PackedBinaryImage::ThresholdDown(const GenericImage<Pixel> &Src, typename Pixel::Type Threshold)
+    {
+        this->Threshold(Src, [Threshold](typename Pixel::Type Value) { return Value < Threshold; });
+    }
+
+    template <typename Pixel>
+    void PackedBinaryImage::Otsu(const GenericImage<Pixel> &Src, uint32_t Bins)
+    {
+        ThresholdUp(Src, BinaryImage::OtsuThreshold(Src, Bins));
+    }
+
+    template <typename Pixel>
+    void PackedBinaryImage::Niblack(const GenericImage<Pixel> &Src, uint32_t WindowSize, double K)
+    {
+        Create(Src.GetWidth(), Src.GetHeight());
+        PackedRowSink Sink(*this);
+        BinaryImage::LocalThreshold<true>(Src, 0, Src.GetHeight(), WindowSize, BinaryImage::NiblackFunction(K), Sink);
+    }
+
+    template <typename Pixel>
+    void PackedBinaryImage::Sauvola(const GenericImage<Pixel> &Src, uint32_t WindowSize, double K)
+    {
+        Create(Src.GetWidth(), Src.GetHeight());
+        PackedRowSink Sink(*this);
+        BinaryImage::LocalThreshold<true>(Src, 0, Src.GetHeight(), WindowSize,
+                                          BinaryImage::SauvolaFunction(WindowSize, K), Sink);
+    }
+
+    template <typename Pixel>
+    void PackedBinaryImage::BoxMean(const GenericImage<Pixel> &Src, uint32_t WindowSize, double K)
+    {
+        Create(Src.GetWidth(), Src.GetHeight());
+        PackedRowSink Sink(*this);
+        BinaryImage::LocalThreshold<false>(Src, 0, Src.GetHeight(), WindowSize, BinaryImage::BoxMeanFunction(K), Sink);
+    }
+};
+#endif //JIMLIB_PACKEDBINARYIMAGE_HPP
@@ -26,6 +26,7 @@
 #ifndef JIMLIB_PIXELTYPES_HPP
 #define JIMLIB_PIXELTYPES_HPP
 
+#include <type_traits>
 #include "Image/GenericPixel.hpp"
 namespace jimlib
 {
@@ -42,63 +43,74 @@ namespace jimlib
     }
     namespace PixelType
     {
-        class Mono8 : public GenericPixel<uint8_t, 1>
+        class Mono8 : public PixelValue<uint8_t, 1>
         {
         public:
-            Mono8();
-            Mono8(uint8_t Value);
-            Mono8(const Mono8 &Pixel);
-            uint8_t &Value;
+            typedef Mono8 ValueType;
+            constexpr Mono8();
+            constexpr Mono8(uint8_t Value);
+            uint8_t &Value();
+            const uint8_t &Value() const;
         };
 
-        class Mono16 : public GenericPixel<uint16_t, 1>
+        class Mono16 : public PixelValue<uint16_t, 1>
         {
         public:
-            Mono16();
-            Mono16(uint16_t Value);
-            Mono16(const Mono16 &Pixel);
-            uint16_t &Value;
+            typedef Mono16 ValueType;
+            constexpr Mono16();
+            constexpr Mono16(uint16_t Value);
+            uint16_t &Value();
+            const uint16_t &Value() const;
         };
 
-        class Mono32 : public GenericPixel<uint32_t, 1>
+        class Mono32 : public PixelValue<uint32_t, 1>
         {
         public:
-            Mono32();
-            Mono32(uint32_t Value);
-            Mono32(const Mono32 &Pixel);
-            uint32_t &Value;
+            typedef Mono32 ValueType;
+            constexpr Mono32();
+            constexpr Mono32(uint32_t Value);
+            uint32_t &Value();
+            const uint32_t &Value() const;
         };
 
-        class Mono64 : public GenericPixel<uint64_t, 1>
+        class Mono64 : public PixelValue<uint64_t, 1>
         {
         public:
-            Mono64();
-            Mono64(uint64_t Value);
-            Mono64(const Mono64 &Pixel);
-            uint64_t &Value;
+            typedef Mono64 ValueType;
+            constexpr Mono64();
+            constexpr Mono64(uint64_t Value);
+            uint64_t &Value();
+            const uint64_t &Value() const;
         };
 
-        class RGB24 : public GenericPixel<uint8_t, 3>
+        class RGB24 : public PixelValue<uint8_t, 3>
         {
         public:
-            RGB24();
-            RGB24(uint8_t R, uint8_t G, uint8_t B);
-            RGB24(const RGB24 &Pixel);
-            uint8_t &R;
-            uint8_t &G;
-            uint8_t &B;
+            typedef RGB24 ValueType;
+            constexpr RGB24();
+            constexpr RGB24(uint8_t R, uint8_t G, uint8_t B);
+            uint8_t &R();
+            const uint8_t &R() const;
+            uint8_t &G();
+            const uint8_t &G() const;
+            uint8_t &B();
+            const uint8_t &B() const;
         };
 
-        class RGBA32 : public GenericPixel<uint8_t, 4>
+        class RGBA32 : public PixelValue<uint8_t, 4>
         {
         public:
-            RGBA32();
-            RGBA32(uint8_t R, uint8_t G, uint8_t B, uint8_t A);
-            RGBA32(const RGBA32 &Pixel);
-            uint8_t &R;
-            uint8_t &G;
-            uint8_t &B;
-            uint8_t &A;
+            typedef RGBA32 ValueType;
+            constexpr RGBA32();
+            constexpr RGBA32(uint8_t R, uint8_t G, uint8_t B, uint8_t A);
+            uint8_t &R();
+            const uint8_t &R() const;
+            uint8_t &G();
+            const uint8_t &G() const;
+            uint8_t &B();
+            const uint8_t &B() const;
+            uint8_t &A();
+            const uint8_t &A() const;
         };
     }
 
@@ -106,142 +118,177 @@ namespace jimlib
 
     using namespace PixelType;
 
-    inline Mono8::Mono8()
-            : Value(m_Buffer[0])
+    constexpr Mono8::Mono8()
+            : PixelValue<uint8_t, 1>()
     {
-        Value = 0;
     }
 
-    inline Mono8::Mono8(uint8_t _Value)
-            : Value(m_Buffer[0])
+    constexpr Mono8::Mono8(uint8_t _Value)
+            : PixelValue<uint8_t, 1>(_Value)
     {
-        Value = _Value;
     }
 
-    inline Mono8::Mono8(const Mono8 &Pixel)
-            : Value(m_Buffer[0])
+    inline uint8_t &Mono8::Value()
     {
-        Value = Pixel.Value;
+        return m_Buffer[0];
     }
 
-    inline Mono16::Mono16()
-            : Value(m_Buffer[0])
+    inline const uint8_t &Mono8::Value() const
     {
-        Value = 0;
+        return m_Buffer[0];
     }
 
-    inline Mono16::Mono16(uint16_t _Value)
-            : Value(m_Buffer[0])
+    constexpr Mono16::Mono16()
+            : PixelValue<uint16_t, 1>()
     {
-        Value = _Value;
     }
 
-    inline Mono16::Mono16(const Mono16 &Pixel)
-            : Value(m_Buffer[0])
+    constexpr Mono16::Mono16(uint16_t _Value)
+            : PixelValue<uint16_t, 1>(_Value)
     {
-        Value = Pixel.Value;
     }
 
-    inline Mono32::Mono32()
-            : Value(m_Buffer[0])
+    inline uint16_t &Mono16::Value()
     {
-        Value = 0;
+        return m_Buffer[0];
     }
 
-    inline Mono32::Mono32(uint32_t _Value)
-            : Value(m_Buffer[0])
+    inline const uint16_t &Mono16::Value() const
     {
-        Value = _Value;
+        return m_Buffer[0];
     }
 
-    inline Mono32::Mono32(const Mono32 &Pixel)
-            : Value(m_Buffer[0])
+    constexpr Mono32::Mono32()
+            : PixelValue<uint32_t, 1>()
     {
-        Value = Pixel.Value;
     }
 
-    inline Mono64::Mono64()
-            : Value(m_Buffer[0])
+    constexpr Mono32::Mono32(uint32_t _Value)
+            : PixelValue<uint32_t, 1>(_Value)
     {
-        Value = 0;
     }
 
-    inline Mono64::Mono64(uint64_t _Value)
-            : Value(m_Buffer[0])
+    inline uint32_t &Mono32::Value()
     {
-        Value = _Value;
+        return m_Buffer[0];
     }
 
-    inline Mono64::Mono64(const Mono64 &Pixel)
-            : Value(m_Buffer[0])
+    inline const uint32_t &Mono32::Value() const
     {
-        Value = Pixel.Value;
+        return m_Buffer[0];
     }
 
-    inline RGB24::RGB24()
-            : R(m_Buffer[0]),
-              G(m_Buffer[1]),
-              B(m_Buffer[2])
+    constexpr Mono64::Mono64()
+            : PixelValue<uint64_t, 1>()
     {
-        R = 0;
-        G = 0;
-        B = 0;
     }
 
-    inline RGB24::RGB24(uint8_t _R, uint8_t _G, uint8_t _B)
-            : R(m_Buffer[0]),
-              G(m_Buffer[1]),
-              B(m_Buffer[2])
+    constexpr Mono64::Mono64(uint64_t _Value)
+            : PixelValue<uint64_t, 1>(_Value)
     {
-        R = _R;
-        G = _G;
-        B = _B;
     }
 
-    inline RGB24::RGB24(const RGB24 &Pixel)
-            : R(m_Buffer[0]),
-              G(m_Buffer[1]),
-              B(m_Buffer[2])
+    inline uint64_t &Mono64::Value()
     {
-        R = Pixel.R;
-        G = Pixel.G;
-        B = Pixel.B;
+        return m_Buffer[0];
     }
 
-    inline RGBA32::RGBA32()
-            : R(m_Buffer[0]),
-              G(m_Buffer[1]),
-              B(m_Buffer[2]),
-              A(m_Buffer[3])
+    inline const uint64_t &Mono64::Value() const
     {
-        R = 0;
-        G = 0;
-        B = 0;
-        A = 0;
+        return m_Buffer[0];
     }
 
-    inline RGBA32::RGBA32(uint8_t _R, uint8_t _G, uint8_t _B, uint8_t _A)
-            : R(m_Buffer[0]),
-              G(m_Buffer[1]),
-              B(m_Buffer[2]),
-              A(m_Buffer[3])
+    constexpr RGB24::RGB24()
+            : PixelValue<uint8_t, 3>()
     {
-        R = _R;
-        G = _G;
-        B = _B;
-        A = _A;
     }
 
-    inline RGBA32::RGBA32(const RGBA32 &Pixel)
-            : R(m_Buffer[0]),
-              G(m_Buffer[1]),
-              B(m_Buffer[2]),
-              A(m_Buffer[3])
+    constexpr RGB24::RGB24(uint8_t _R, uint8_t _G, uint8_t _B)
+            : PixelValue<uint8_t, 3>(_R, _G, _B)
     {
-        R = Pixel.R;
-        G = Pixel.G;
-        B = Pixel.B;
-        A = Pixel.A;
     }
+
+    inline uint8_t &RGB24::R()
+    {
+        return m_Buffer[0];
+    }
+
+    inline const uint8_t &RGB24::R() const
+    {
+        return m_Buffer[0];
+    }
+
+    inline uint8_t &RGB24::G()
+    {
+        return m_Buffer[1];
+    }
+
+    inline const uint8_t &RGB24::G() const
+    {
+        return m_Buffer[1];
+    }
+
+    inline uint8_t &RGB24::B()
+    {
+        return m_Buffer[2];
+    }
+
+    inline const uint8_t &RGB24::B() const
+    {
+        return m_Buffer[2];
+    }
+
+    constexpr RGBA32::RGBA32()
+            : PixelValue<uint8_t, 4>()
+    {
+    }
+
+    constexpr RGBA32::RGBA32(uint8_t _R, uint8_t _G, uint8_t _B, uint8_t _A)
+            : PixelValue<uint8_t, 4>(_R, _G, _B, _A)
+    {
+    }
+
+    inline uint8_t &RGBA32::R()
+    {
+        return m_Buffer[0];
+    }
+
+    inline const uint8_t &RGBA32::R() const
+    {
+        return m_Buffer[0];
+    }
+
+    inline uint8_t &RGBA32::G()
+    {
+        return m_Buffer[1];
+    }
+
+    inline const uint8_t &RGBA32::G() const
+    {
+        return m_Buffer[1];
+    }
+
+    inline uint8_t &RGBA32::B()
+    {
+        return m_Buffer[2];
+    }
+
+    inline const uint8_t &RGBA32::B() const
+    {
+        return m_Buffer[2];
+    }
+
+    inline uint8_t &RGBA32::A()
+    {
+        return m_Buffer[3];
+    }
+
+    inline const uint8_t &RGBA32::A() const
+    {
+        return m_Buffer[3];
+    }
+
+    static_assert(std::is_trivially_copyable<RGBA32>::value && sizeof(RGBA32) == RGBA32::SizeOfPixel,
+                  "Pixel values should be plain inline storage!");
 };
 #endif //JIMLIB_PIXELTYPES_HPP
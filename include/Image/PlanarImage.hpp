@@ -0,0 +1,562 @@
+/*
+ *  jimlib -- generic image and-image algorithms library
+ *  Copyright (C) 2015 Alexey Titov
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty.  In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ *
+ *  Alexey Titov
+ *  alex.justes@gmail.com
+ *  https://github.com/alex-justes/jimlib
+ */
+
+#ifndef JIMLIB_PLANARIMAGE_HPP
+#define JIMLIB_PLANARIMAGE_HPP
+
+#include "Image/GenericImage.hpp"
+#include "Image/GenericImageView.hpp"
+#include "Utils/Rect.hpp"
+namespace jimlib
+{
+    /*!
+     * Image with planar (structure of arrays) layout: every Plant of the Pixel is stored in its own plane,
+     * so per-plant kernels walk over contiguous memory instead of jumping over other plants.
+     *
+     * All planes live in one buffer one under another (plane p starts at p * GetPlaneSize() bytes) and share
+     * the row offset and alignment. Every plane is available as GenericImageView of the single-plant pixels,
+     * so any algorithm for 1-plant GenericImage can be applied to it directly.
+     *
+     * iterator and const_iterator provide the same interface as the GenericImage ones:
+     * it[Plant] is the Plant of the current pixel.
+     */
+    template<typename Pixel>
+    class PlanarImage
+    {
+    public:
+        typedef GenericPixel<typename Pixel::Type, 1> PlanePixel; //< Pixel of the single plane
+        static const uint8_t Plants = Pixel::Plants; //< Amount of Plants (planes)
+        static const uint32_t SizeOfPlant = sizeof(typename Pixel::Type); //< Size of Plant in bytes
+
+        PlanarImage();
+
+        /*!
+         * Allocate buffer for all planes of the WidthXHeight Image.
+         */
+        void Create(uint32_t Width, uint32_t Height);
+
+        /*!
+         * Allocate buffer for all planes of the WidthXHeight Image and fill it with Value.
+         */
+        void Create(uint32_t Width, uint32_t Height, const typename Pixel::ValueType &Value);
+
+        uint32_t GetWidth() const;
+        uint32_t GetHeight() const;
+
+        /*!
+         * \return Distance in bytes between two successive rows of the plane.
+         */
+        size_t GetOffset() const;
+
+        /*!
+         * \return Distance in bytes between two successive planes.
+         */
+        size_t GetPlaneSize() const;
+
+        uint32_t GetRowAlignment() const;
+
+        /*!
+         * Set alignment of the plane rows, see GenericImage::SetRowAlignment().
+         */
+        void SetRowAlignment(uint32_t Alignment);
+
+        /*!
+         * \return View over the Plant plane, the image should not be empty (there is no empty view).
+         */
+        GenericImageView<PlanePixel> GetPlane(uint8_t Plant);
+
+        /*!
+         * \return Read-only view over the Plant plane, the image should not be empty.
+         */
+        ConstGenericImageView<PlanePixel> GetPlane(uint8_t Plant) const;
+
+        const typename Pixel::Type &GetPixel(uint32_t x, uint32_t y, uint8_t Plant) const;
+        typename Pixel::Type &GetPixel(uint32_t x, uint32_t y, uint8_t Plant);
+        void SetPixel(uint32_t x, uint32_t y, uint8_t Plant, const typename Pixel::Type &Value);
+        typename Pixel::ValueType GetPixel(uint32_t x, uint32_t y) const;
+        void SetPixel(uint32_t x, uint32_t y, const typename Pixel::ValueType &Value);
+
+        /*!
+         * Split interleaved Src into planes. Image is resized to the Src size.
+         */
+        void Deinterleave(const GenericImage<Pixel> &Src);
+
+        /*!
+         * Merge planes into interleaved Dst. Dst is resized to the current size.
+         */
+        void Interleave(GenericImage<Pixel> &Dst) const;
+
+        class const_iterator;
+
+        class iterator
+        {
+            friend class const_iterator;
+        public:
+            iterator();
+            iterator(const typename GenericImage<PlanePixel>::iterator &it, size_t PlaneSize);
+            iterator &operator++();
+            iterator &operator--();
+            void operator+=(size_t offset);
+            void operator-=(size_t offset);
+
+            /*!
+             * \return Pointer to the first Plant of the current Pixel, next plants are GetPlaneSize() bytes further.
+             */
+            typename Pixel::Type *operator*();
+            typename Pixel::Type &operator[](int8_t Plant);
+            bool operator==(const iterator &it) const;
+            bool operator!=(const iterator &it) const;
+            bool operator==(const const_iterator &it) const;
+            bool operator!=(const const_iterator &it) const;
+        private:
+            typename GenericImage<PlanePixel>::iterator m_It; //< Position in the first plane
+            size_t m_PlaneSize; //< Distance between planes in bytes
+        };
+
+        class const_iterator
+        {
+            friend class iterator;
+        public:
+            const_iterator();
+            const_iterator(const typename GenericImage<PlanePixel>::const_iterator &it, size_t PlaneSize);
+            const_iterator(const iterator &it);
+            const_iterator &operator++();
+            const_iterator &operator--();
+            void operator+=(size_t offset);
+            void operator-=(size_t offset);
+
+            /*!
+             * \return Pointer to the first Plant of the current Pixel, next plants are GetPlaneSize() bytes further.
+             */
+            const typename Pixel::Type *operator*() const;
+            const typename Pixel::Type &operator[](int8_t Plant) const;
+            bool operator==(const const_iterator &it) const;
+            bool operator!=(const const_iterator &it) const;
+            bool operator==(const iterator &it) const;
+            bool operator!=(const iterator &it) const;
+        private:
+            typename GenericImage<PlanePixel>::const_iterator m_It; //< Position in the first plane
+            size_t m_PlaneSize; //< Distance between planes in bytes
+        };
+
+        iterator begin();
+        iterator end();
+        iterator GetRow(uint32_t Row);
+        iterator GetColRow(uint32_t Col, uint32_t Row);
+        const_iterator begin() const;
+        const_iterator end() const;
+        const_iterator GetRow(uint32_t Row) const;
+        const_iterator GetColRow(uint32_t Col, uint32_t Row) const;
+    private:
+        GenericImage<PlanePixel> m_Planes; //< All planes stacked vertically
+        uint32_t m_Height; //< Height of the single plane
+    };
+
+// =======================================================
+
+    template<typename Pixel>
+    PlanarImage<Pixel>::PlanarImage()
+            : m_Height(0)
+    {
+        static_assert(CheckTypes<GenericPixel<typename Pixel::Type, Pixel::Plants>,
+                              typename Pixel::ParentType>::areSame,
+                      "Type is not GenericPixel<T, uint8_t Plants>!");
+    }
+
+    template<typename Pixel>
+    void PlanarImage<Pixel>::Create(uint32_t Width, uint32_t Height)
+    {
+        assert((uint64_t) Height * Plants <= 0xFFFFFFFFu);
+        m_Planes.Create(Width, Height * Plants);
+        m_Height = Height;
+    }
+
+    template<typename Pixel>
+    void PlanarImage<Pixel>::Create(uint32_t Width, uint32_t Height, const typename Pixel::ValueType &Value)
+    {
+        Create(Width, Height);
+        for (uint8_t p = 0; p < Plants; ++p)
+        {
+            GetPlane(p).Create(Width, Height, typename PlanePixel::ValueType(Value[p]));
+        }
+    }
+
+    template<typename Pixel>
+    uint32_t PlanarImage<Pixel>::GetWidth() const
+    {
+        return m_Planes.GetWidth();
+    }
+
+    template<typename Pixel>
+    uint32_t PlanarImage<Pixel>::GetHeight() const
+    {
+        return m_Height;
+    }
+
+    template<typename Pixel>
+    size_t PlanarImage<Pixel>::GetOffset() const
+    {
+        return m_Planes.GetOffset();
+    }
+
+    template<typename Pixel>
+    size_t PlanarImage<Pixel>::GetPlaneSize() const
+    {
+        return m_Planes.GetOffset() * m_Height;
+    }
+
+    template<typename Pixel>
+    uint32_t PlanarImage<Pixel>::GetRowAlignment() const
+    {
+        return m_Planes.GetRowAlignment();
+    }
+
+    template<typename Pixel>
+    void PlanarImage<Pixel>::SetRowAlignment(uint32_t Alignment)
+    {
+        m_Planes.SetRowAlignment(Alignment);
+    }
+
+    template<typename Pixel>
+    GenericImageView<typename PlanarImage<Pixel>::PlanePixel> PlanarImage<Pixel>::GetPlane(uint8_t Plant)
+    {
+        assert(Plant < Plants);
+        assert(GetWidth() > 0 && m_Height > 0);
+        return GenericImageView<PlanePixel>(m_Planes, Rect<uint32_t>(Plant * m_Height, 0, (Plant + 1) * m_Height - 1,
+                                                                     GetWidth() - 1));
+    }
+
+    template<typename Pixel>
+    ConstGenericImageView<typename PlanarImage<Pixel>::PlanePixel> PlanarImage<Pixel>::GetPlane(uint8_t Plant) const
+    {
+        assert(Plant < Plants);
+        assert(GetWidth() > 0 && m_Height > 0);
+        return ConstGenericImageView<PlanePixel>(m_Planes, Rect<uint32_t>(Plant * m_Height, 0,
+                                                                          (Plant + 1) * m_Height - 1, GetWidth() - 1));
+    }
+
+    template<typename Pixel>
+    const typename Pixel::Type &PlanarImage<Pixel>::GetPixel(uint32_t x, uint32_t y, uint8_t Plant) const
+    {
+        assert(Plant < Plants);
+        return m_Planes.GetPixel(x, Plant * m_Height + y, 0);
+    }
+
+    template<typename Pixel>
+    typename Pixel::Type &PlanarImage<Pixel>::GetPixel(uint32_t x, uint32_t y, uint8_t Plant)
+    {
+        assert(Plant < Plants);
+        return m_Planes.GetPixel(x, Plant * m_Height + y, 0);
+    }
+
+    template<typename Pixel>
+    void PlanarImage<Pixel>::SetPixel(uint32_t x, uint32_t y, uint8_t Plant, const typename Pixel::Type &Value)
+    {
+        GetPixel(x, y, Plant) = Value;
+    }
+
+    template<typename Pixel>
+    typename Pixel::ValueType PlanarImage<Pixel>::GetPixel(uint32_t x, uint32_t y) const
+    {
+        typename Pixel::ValueType pix;
+        for (uint8_t p = 0; p < Plants; ++p)
+        {
+            pix[p] = GetPixel(x, y, p);
+        }
+        return pix;
+    }
+
+    template<typename Pixel>
+    void PlanarImage<Pixel>::SetPixel(uint32_t x, uint32_t y, const typename Pixel::ValueType &Value)
+    {
+        for (uint8_t p = 0; p < Plants; ++p)
+        {
+            GetPixel(x, y, p) = Value[p];
+        }
+    }
+
+    template<typename Pixel>
+    void PlanarImage<Pixel>::Deinterleave(const GenericImage<Pixel> &Src)
+    {
+        uint32_t W = Src.GetWidth();
+        uint32_t H = Src.GetHeight();
+        Create(W, H);
+        size_t PlaneSize = GetPlaneSize();
+        for (uint32_t y = 0; y < H; ++y)
+        {
+            const typename Pixel::Type *pSrc = *Src.GetRow(y);
+            uint8_t *pRow = reinterpret_cast<uint8_t *>(*m_Planes.GetRow(y));
+            typename Pixel::Type *pPlanes[Plants];
+            for (uint8_t p = 0; p < Plants; ++p)
+            {
+                pPlanes[p] = reinterpret_cast<typename Pixel::Type *>(pRow + p * PlaneSize);
+            }
+            // Plants is known at compile time, so the inner loop is unrolled and the row loop is vectorized.
+            for (uint32_t x = 0; x < W; ++x, pSrc += Plants)
+            {
+                for (uint8_t p = 0; p < Plants; ++p)
+                {
+                    pPlanes[p][x] = pSrc[p];
+                }
+            }
+        }
+    }
+
+    template<typename Pixel>
+    void PlanarImage<Pixel>::Interleave(GenericImage<Pixel> &Dst) const
+    {
+        uint32_t W = GetWidth();
+        uint32_t H = GetHeight();
+        Dst.Create(W, H);
+        size_t PlaneSize = GetPlaneSize();
+        for (uint32_t y = 0; y < H; ++y)
+        {
+            typename Pixel::Type *pDst = *Dst.GetRow(y);
+            const uint8_t *pRow = reinterpret_cast<const uint8_t *>(*m_Planes.GetRow(y));
+            const typename Pixel::Type *pPlanes[Plants];
+            for (uint8_t p = 0; p < Plants; ++p)
+            {
+                pPlanes[p] = reinterpret_cast<const typename Pixel::Type *>(pRow + p * PlaneSize);
+            }
+            for (uint32_t x = 0; x < W; ++x, pDst += Plants)
+            {
+                for (uint8_t p = 0; p < Plants; ++p)
+                {
+                    pDst[p] = pPlanes[p][x];
+                }
+            }
+        }
+    }
+
+    template<typename Pixel>
+    typename PlanarImage<Pixel>::iterator PlanarImage<Pixel>::begin()
+    {
+        return GetColRow(0, 0);
+    }
+
+    template<typename Pixel>
+    typename PlanarImage<Pixel>::iterator PlanarImage<Pixel>::end()
+    {
+        return GetColRow(0, m_Height);
+    }
+
+    template<typename Pixel>
+    typename PlanarImage<Pixel>::iterator PlanarImage<Pixel>::GetRow(uint32_t Row)
+    {
+        return GetColRow(0, Row);
+    }
+
+    template<typename Pixel>
+    typename PlanarImage<Pixel>::iterator PlanarImage<Pixel>::GetColRow(uint32_t Col, uint32_t Row)
+    {
+        return iterator(m_Planes.GetColRow(Col, Row), GetPlaneSize());
+    }
+
+    template<typename Pixel>
+    typename PlanarImage<Pixel>::const_iterator PlanarImage<Pixel>::begin() const
+    {
+        return GetColRow(0, 0);
+    }
+
+    template<typename Pixel>
+    typename PlanarImage<Pixel>::const_iterator PlanarImage<Pixel>::end() const
+    {
+        return GetColRow(0, m_Height);
+    }
+
+    template<typename Pixel>
+    typename PlanarImage<Pixel>::const_iterator PlanarImage<Pixel>::GetRow(uint32_t Row) const
+    {
+        return GetColRow(0, Row);
+    }
+
+    template<typename Pixel>
+    typename PlanarImage<Pixel>::const_iterator PlanarImage<Pixel>::GetColRow(uint32_t Col, uint32_t Row) const
+    {
+        return const_iterator(m_Planes.GetColRow(Col, Row), GetPlaneSize());
+    }
+
+    template<typename Pixel>
+    PlanarImage<Pixel>::iterator::iterator()
+            : m_PlaneSize(0)
+    {
+    }
+
+    template<typename Pixel>
+    PlanarImage<Pixel>::iterator::iterator(const typename GenericImage<PlanePixel>::iterator &it, size_t PlaneSize)
+            : m_It(it),
+              m_PlaneSize(PlaneSize)
+    {
+    }
+
+    template<typename Pixel>
+    typename PlanarImage<Pixel>::iterator &PlanarImage<Pixel>::iterator::operator++()
+    {
+        ++m_It;
+        return *this;
+    }
+
+    template<typename Pixel>
+    typename PlanarImage<Pixel>::iterator &PlanarImage<Pixel>::iterator::operator--()
+    {
+        --m_It;
+        return *this;
+    }
+
+    template<typename Pixel>
+    void PlanarImage<Pixel>::iterator::operator+=(size_t offset)
+    {
+        m_It += offset;
+    }
+
+    template<typename Pixel>
+    void PlanarImage<Pixel>::iterator::operator-=(size_t offset)
+    {
+        m_It -= offset;
+    }
+
+    template<typename Pixel>
+    typename Pixel::Type *PlanarImage<Pixel>::iterator::operator*()
+    {
+        return *m_It;
+    }
+
+    template<typename Pixel>
+    typename Pixel::Type &PlanarImage<Pixel>::iterator::operator[](int8_t Plant)
+    {
+        assert(Plant >= 0 && Plant < Plants);
+        return *reinterpret_cast<typename Pixel::Type *>(reinterpret_cast<uint8_t *>(*m_It) + Plant * m_PlaneSize);
+    }
+
+    template<typename Pixel>
+    bool PlanarImage<Pixel>::iterator::operator==(const iterator &it) const
+    {
+        return m_It == it.m_It;
+    }
+
+    template<typename Pixel>
+    bool PlanarImage<Pixel>::iterator::operator!=(const iterator &it) const
+    {
+        return m_It != it.m_It;
+    }
+
+    template<typename Pixel>
+    bool PlanarImage<Pixel>::iterator::operator==(const const_iterator &it) const
+    {
+        return m_It == it.m_It;
+    }
+
+    template<typename Pixel>
+    bool PlanarImage<Pixel>::iterator::operator!=(const const_iterator &it) const
+    {
+        return m_It != it.m_It;
+    }
+
+    template<typename Pixel>
+    PlanarImage<Pixel>::const_iterator::const_iterator()
+            : m_PlaneSize(0)
+    {
+    }
+
+    template<typename Pixel>
+    PlanarImage<Pixel>::const_iterator::const_iterator(const typename GenericImage<PlanePixel>::const_iterator &it,
+                                                       size_t PlaneSize)
+            : m_It(it),
+              m_PlaneSize(PlaneSize)
+    {
+    }
+
+    template<typename Pixel>
+    PlanarImage<Pixel>::const_iterator::const_iterator(const iterator &it)
+            : m_It(it.m_It),
+              m_PlaneSize(it.m_PlaneSize)
+    {
+    }
+
+    template<typename Pixel>
+    typename PlanarImage<Pixel>::const_iterator &PlanarImage<Pixel>::const_iterator::operator++()
+    {
+        ++m_It;
+        return *this;
+    }
+
+    template<typename Pixel>
+    typename PlanarImage<Pixel>::const_iterator &PlanarImage<Pixel>::const_iterator::operator--()
+    {
+        --m_It;
+        return *this;
+    }
+
+    template<typename Pixel>
+    void PlanarImage<Pixel>::const_iterator::operator+=(size_t offset)
+    {
+        m_It += offset;
+    }
+
+    template<typename Pixel>
+    void PlanarImage<Pixel>::const_iterator::operator-=(size_t offset)
+    {
+        m_It -= offset;
+    }
+
+    template<typename Pixel>
+    const typename Pixel::Type *PlanarImage<Pixel>::const_iterator::operator*() const
+    {
+        return *m_It;
+    }
+
+    template<typename Pixel>
+    const typename Pixel::Type &PlanarImage<Pixel>::const_iterator::operator[](int8_t Plant) const
+    {
+        assert(Plant >= 0 && Plant < Plants);
+        return *reinterpret_cast<const typename Pixel::Type *>(reinterpret_cast<const uint8_t *>(*m_It)
+                                                               + Plant * m_PlaneSize);
+    }
+
+    template<typename Pixel>
+    bool PlanarImage<Pixel>::const_iterator::operator==(const const_iterator &it) const
+    {
+        return m_It == it.m_It;
+    }
+
+    template<typename Pixel>
+    bool PlanarImage<Pixel>::const_iterator::operator!=(const const_iterator &it) const
+    {
+        return m_It != it.m_It;
+    }
+
+    template<typename Pixel>
+    bool PlanarImage<Pixel>::const_iterator::operator==(const iterator &it) const
+    {
+        return m_It == it.m_It;
+    }
+
+    template<typename Pixel>
+    bool PlanarImage<Pixel>::const_iterator::operator!=(const iterator &it) const
+    {
+        return m_It != it.m_It;
+    }
+};
+#endif //JIMLIB_PLANARIMAGE_HPP
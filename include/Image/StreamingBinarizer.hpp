@@ -0,0 +1,258 @@
+/*
+ *  jimlib -- generic image and-image algorithms library
+ *  Copyright (C) 2015 Alexey Titov
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty.  In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ *
+ *  Alexey Titov
+ *  alex.justes@gmail.com
+ *  https://github.com/alex-justes/jimlib
+ */
+
+#ifndef JIMLIB_STREAMINGBINARIZER_HPP
+#define JIMLIB_STREAMINGBINARIZER_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <vector>
+#include "Image/BinaryImage.hpp"
+#include "Image/ImageBand.hpp"
+namespace jimlib
+{
+    /*!
+     * Niblack, Sauvola and BoxMean binarization of the row stream (i.e. behind the row-by-row decoder).
+     *
+     * Instead of the two integral images of the whole image (16 bytes per pixel) it keeps a ring of the last
+     * 2 * (WindowSize / 2) + 2 rows of the source and the sums of every column over the rows of the current window.
+     * Row y is binarized as soon as row y + WindowSize / 2 is pushed and is written to the BandWriter
+     * as a band of one row. Result is the same as BinaryImage::Niblack(), Sauvola() and BoxMean(): thresholds
+     * are compared by the same BinaryImage::BinarizeRow().
+     * \code
+     * StreamingBinarizer<PixelType::Mono8> Binarizer;
+     * Binarizer.Sauvola(Width, Height, WindowSize, K, Writer);
+     * while (Decoder.ReadRow(pRow))
+     * {
+     *     Binarizer.PushRow(pRow);
+     * }
+     * \endcode
+     */
+    template<typename Pixel>
+    class StreamingBinarizer
+    {
+        static_assert(GenericImage<Pixel>::Plants == 1, "Binary image supports only images with 1 plant.");
+    public:
+        typedef typename Pixel::Type Type;
+
+        StreamingBinarizer();
+
+        /*!
+         * Start binarization of the WidthXHeight image, rows are expected with PushRow().
+         */
+        void Niblack(uint32_t Width, uint32_t Height, uint32_t WindowSize, double K, BandWriter<PixelType::Mono8> &Dst);
+        void Sauvola(uint32_t Width, uint32_t Height, uint32_t WindowSize, double K, BandWriter<PixelType::Mono8> &Dst);
+        void BoxMean(uint32_t Width, uint32_t Height, uint32_t WindowSize, double K, BandWriter<PixelType::Mono8> &Dst);
+
+        /*!
+         * Pass the next row of the source (Width values), ready rows are written to Dst.
+         */
+        void PushRow(const Type *pRow);
+
+        /*!
+         * Push all rows of Src one by one.
+         */
+        void PushRows(BandReader<Pixel> &Src);
+
+        /*!
+         * \return Amount of rows pushed so far.
+         */
+        uint32_t GetPushedRows() const;
+    private:
+        void Start(uint32_t Width, uint32_t Height, uint32_t WindowSize, BandWriter<PixelType::Mono8> &Dst);
+
+        template<bool Squared, typename Function>
+        void OutputRow(uint32_t y, Function Threshold);
+
+        const Type *GetRing(uint32_t y) const;
+
+        uint32_t m_Width;
+        uint32_t m_Height;
+        uint32_t m_Half; //< WindowSize / 2
+        uint32_t m_Pushed; //< Rows pushed (and added to the column sums)
+        uint32_t m_Removed; //< Rows removed from the column sums
+        uint32_t m_Output; //< Rows written to Dst
+        GenericImage<Pixel> m_Ring; //< Last rows of the source, row y is stored in y % RingSize
+        std::vector<uint64_t> m_ColumnSum;
+        std::vector<uint64_t> m_ColumnSq;
+        std::vector<uint64_t> m_RowSum; //< Prefix sums of the column sums
+        std::vector<uint64_t> m_RowSq;
+        std::vector<double> m_Window; //< Window sums, squared sums and 1 / Area of the output row
+        BinaryImage m_Row;
+        BandWriter<PixelType::Mono8> *m_pDst;
+        std::function<void(uint32_t y)> m_OutputRow;
+    };
+
+// =======================================================
+
+    template<typename Pixel>
+    StreamingBinarizer<Pixel>::StreamingBinarizer()
+            : m_Width(0),
+              m_Height(0),
+              m_Half(0),
+              m_Pushed(0),
+              m_Removed(0),
+              m_Output(0),
+              m_pDst(nullptr)
+    {
+    }
+
+    template<typename Pixel>
+    void StreamingBinarizer<Pixel>::Start(uint32_t Width, uint32_t Height, uint32_t WindowSize,
+                                          BandWriter<PixelType::Mono8> &Dst)
+    {
+        assert(Width > 0 && Height > 0);
+        m_Width = Width;
+        m_Height = Height;
+        m_Half = WindowSize / 2;
+        m_Pushed = 0;
+        m_Removed = 0;
+        m_Output = 0;
+        // Row y - Half - 1 is removed when row y + Half is already pushed
+        m_Ring.Create(Width, (uint32_t) std::min<uint64_t>(2 * (uint64_t) m_Half + 2, Height));
+        m_ColumnSum.assign(Width, 0);
+        m_ColumnSq.assign(Width, 0);
+        m_RowSum.assign(Width + 1, 0);
+        m_RowSq.assign(Width + 1, 0);
+        m_Window.assign((size_t) 3 * Width, 0);
+        m_Row.Create(Width, 1);
+        m_pDst = &Dst;
+    }
+
+    template<typename Pixel>
+    void StreamingBinarizer<Pixel>::Niblack(uint32_t Width, uint32_t Height, uint32_t WindowSize, double K,
+                                            BandWriter<PixelType::Mono8> &Dst)
+    {
+        Start(Width, Height, WindowSize, Dst);
+        BinaryImage::NiblackFunction Function(K);
+        m_OutputRow = [this, Function](uint32_t y) { OutputRow<true>(y, Function); };
+    }
+
+    template<typename Pixel>
+    void StreamingBinarizer<Pixel>::Sauvola(uint32_t Width, uint32_t Height, uint32_t WindowSize, double K,
+                                            BandWriter<PixelType::Mono8> &Dst)
+    {
+        Start(Width, Height, WindowSize, Dst);
+        BinaryImage::SauvolaFunction Function(WindowSize, K);
+        m_OutputRow = [this, Function](uint32_t y) { OutputRow<true>(y, Function); };
+    }
+
+    template<typename Pixel>
+    void StreamingBinarizer<Pixel>::BoxMean(uint32_t Width, uint32_t Height, uint32_t WindowSize, double K,
+                                            BandWriter<PixelType::Mono8> &Dst)
+    {
+        Start(Width, Height, WindowSize, Dst);
+        BinaryImage::BoxMeanFunction Function(K);
+        m_OutputRow = [this, Function](uint32_t y) { OutputRow<false>(y, Function); };
+    }
+
+    template<typename Pixel>
+    const typename Pixel::Type *StreamingBinarizer<Pixel>::GetRing(uint32_t y) const
+    {
+        return *m_Ring.GetRow(y % m_Ring.GetHeight());
+    }
+
+    template<typename Pixel>
+    void StreamingBinarizer<Pixel>::PushRow(const Type *pRow)
+    {
+        assert(m_pDst != nullptr && m_Pushed < m_Height);
+        memcpy(*m_Ring.GetRow(m_Pushed % m_Ring.GetHeight()), pRow, (size_t) m_Width * sizeof(Type));
+        for (uint32_t x = 0; x < m_Width; ++x)
+        {
+            uint64_t Value = pRow[x];
+            m_ColumnSum[x] += Value;
+            m_ColumnSq[x] += Value * Value;
+        }
+        ++m_Pushed;
+        // Row y needs rows up to y + Half (or the last one)
+        while (m_Output < m_Height && (m_Pushed == m_Height || m_Pushed > m_Output + m_Half))
+        {
+            m_OutputRow(m_Output);
+            ++m_Output;
+        }
+    }
+
+    template<typename Pixel>
+    void StreamingBinarizer<Pixel>::PushRows(BandReader<Pixel> &Src)
+    {
+        GenericImage<Pixel> Row;
+        Row.Create(Src.GetWidth(), 1);
+        for (uint32_t y = m_Pushed; y < m_Height; ++y)
+        {
+            Src.Read(y, Row);
+            PushRow(*Row.GetRow(0));
+        }
+    }
+
+    template<typename Pixel>
+    uint32_t StreamingBinarizer<Pixel>::GetPushedRows() const
+    {
+        return m_Pushed;
+    }
+
+    template<typename Pixel>
+    template<bool Squared, typename Function>
+    void StreamingBinarizer<Pixel>::OutputRow(uint32_t y, Function Threshold)
+    {
+        uint32_t W = m_Width;
+        uint32_t Half = m_Half;
+        uint32_t Top = (y > Half) ? y - Half : 0;
+        uint32_t Bottom = (uint32_t) std::min<uint64_t>((uint64_t) y + Half, m_Height - 1);
+        for (; m_Removed < Top; ++m_Removed)
+        {
+            const Type *pOld = GetRing(m_Removed);
+            for (uint32_t x = 0; x < W; ++x)
+            {
+                uint64_t Value = pOld[x];
+                m_ColumnSum[x] -= Value;
+                m_ColumnSq[x] -= Value * Value;
+            }
+        }
+        for (uint32_t x = 0; x < W; ++x)
+        {
+            m_RowSum[x + 1] = m_RowSum[x] + m_ColumnSum[x];
+            if (Squared)
+            {
+                m_RowSq[x + 1] = m_RowSq[x] + m_ColumnSq[x];
+            }
+        }
+        double Rows = Bottom - Top + 1;
+        double *pSum = m_Window.data();
+        double *pSq = pSum + W;
+        double *pScale = pSq + W;
+        for (uint32_t x = 0; x < W; ++x)
+        {
+            uint32_t Left = (x > Half) ? x - Half : 0;
+            uint32_t Right = (uint32_t) std::min<uint64_t>((uint64_t) x + Half, W - 1);
+            pSum[x] = m_RowSum[Right + 1] - m_RowSum[Left];
+            pSq[x] = Squared ? m_RowSq[Right + 1] - m_RowSq[Left] : 0;
+            pScale[x] = 1.0 / (Rows * (Right - Left + 1));
+        }
+        BinaryImage::BinarizeRow(GetRing(y), pSum, pSq, pScale, W, Threshold, *m_Row.GetRow(0));
+        m_pDst->Write(y, m_Row);
+    }
+};
+#endif //JIMLIB_STREAMINGBINARIZER_HPP
@@ -27,7 +27,7 @@
 #define JIMLIB_CLUSTER_HPP
 
 #include <memory>
-#include <list>
+#include <vector>
 #include "Image/PixelTypes.hpp"
 #include "Image/BinaryImage.hpp"
 #include "Utils/MinMax.hpp"
@@ -66,9 +66,9 @@ namespace jimlib
         static const uint32_t MaxClusters = UINT16_MAX;
 
         template<typename Pixel>
-        uint16_t ClusterizeMask(const GenericImage<Pixel> &Image, const BinaryImage &Mask, bool CalculateRoi = false);
+        uint16_t ClusterizeMask(const GenericImage<Pixel> &Image, const GenericImage<PixelType::Mono8> &Mask, bool CalculateRoi = false);
 
-        uint16_t Clusterize(const BinaryImage &Image, bool CalculateRoi = false);
+        uint16_t Clusterize(const GenericImage<PixelType::Mono8> &Image, bool CalculateRoi = false);
 
         uint16_t GetClustersAmount() const;
 
@@ -82,12 +82,13 @@ namespace jimlib
             uint16_t Parent;
             ClusterItem * pClusters;
         };
-        void ClusterizeInternal(const BinaryImage &Image);
+        void ClusterizeInternal(const GenericImage<PixelType::Mono8> &Image);
 
         template<typename Pixel>
         uint16_t ExtractClustersInternal(const GenericImage<Pixel> &Image, bool CalculateRoi);
 
         ClusterItem m_Clusters[UINT16_MAX];
+        std::vector<std::pair<uint32_t, uint32_t>> m_Pairs;
         uint16_t m_ClustersAmount;
         uint16_t m_LookUpTable_Equiv[MaxIdx + 1];
         uint16_t m_LookUpTable_Idx[MaxIdx + 1];
@@ -96,7 +97,7 @@ namespace jimlib
 // =======================================================
 
     template<typename Pixel>
-    uint16_t Cluster::ClusterizeMask(const GenericImage<Pixel> &Image, const BinaryImage &Mask, bool CalculateRoi)
+    uint16_t Cluster::ClusterizeMask(const GenericImage<Pixel> &Image, const GenericImage<PixelType::Mono8> &Mask, bool CalculateRoi)
     {
         static_assert(GenericImage<Pixel>::Plants == 1, "Only Images with 1 plant are allowed!");
         ClusterizeInternal(Mask);
@@ -178,7 +179,7 @@ namespace jimlib
         }
     }
 
-    inline uint16_t Cluster::Clusterize(const BinaryImage &Image, bool CalculateRoi)
+    inline uint16_t Cluster::Clusterize(const GenericImage<PixelType::Mono8> &Image, bool CalculateRoi)
     {
         ClusterizeInternal(Image);
         return ExtractClustersInternal(Image, CalculateRoi);
@@ -192,7 +193,7 @@ namespace jimlib
     {
         return (m_Clusters[idx]);
     }
-    inline void Cluster::ClusterizeInternal(const BinaryImage &Image)
+    inline void Cluster::ClusterizeInternal(const GenericImage<PixelType::Mono8> &Image)
     {
         const unsigned int MaxInt = MaxIdx;
         Create(Image.GetWidth(), Image.GetHeight(), PixelType::Mono16(MaxInt));
@@ -211,7 +212,7 @@ namespace jimlib
             Cluster::iterator _l = GetColRow(0, y);
             Cluster::iterator *Neighbours[4] = {&_ul, &_u, &_ur, &_l};
             Cluster::iterator _c = GetColRow(1, y);
-            BinaryImage::const_iterator it = Image.GetColRow(1, y);
+            GenericImage<PixelType::Mono8>::const_iterator it = Image.GetColRow(1, y);
             for (uint32_t x = 1; x < Image.GetWidth() - 1; ++x, ++_ul, ++_u, ++_l, ++_c, ++_ur, ++it)
             {
                 if (it[0] > 0)
@@ -253,7 +254,7 @@ namespace jimlib
         {
             m_Clusters[i].m_Used = false;
         }
-        std::list<std::pair<uint32_t,uint32_t>> pairs;
+        m_Pairs.clear();
         for (uint32_t i = 0; i < m_ClustersAmount; ++i)
         {
             if (!m_Clusters[i].m_Used)
@@ -265,13 +266,13 @@ namespace jimlib
                     double D = sqrt(Dy*Dy + Dx*Dx);
                     if (D < Distance)
                     {
-                        pairs.push_back(std::make_pair(i,j));
+                        m_Pairs.push_back(std::make_pair(i,j));
                     }
                 }
             }
         }
         
-        for (const auto &p : pairs)
+        for (const auto &p : m_Pairs)
         {
             // Always merge with first
             bool usedBoth = m_Clusters[p.first].m_Used && m_Clusters[p.second].m_Used;
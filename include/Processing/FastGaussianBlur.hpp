@@ -27,23 +27,108 @@
 #define JIMLIB_FASTGAUSSIANBLUR_HPP
 
 #include <cmath>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <vector>
 #include "Image/GenericImage.hpp"
+#include "Image/PlanarImage.hpp"
 #include "Image/PixelTypes.hpp"
+#include "Utils/CpuFeatures.hpp"
+#include "Utils/ThreadPool.hpp"
 namespace jimlib
 {
+    /*!
+     * Gaussian blur by Passes box blurs.
+     * Box means between the passes are kept in the images of the Intermediate type:
+     *  - uint16_t: integer means (truncated after every pass), 8 and 16 bit pixels;
+     *  - uint32_t: means in fixed point with 8 fraction bits, 8 and 16 bit pixels;
+     *  - float: float means, any pixels (the default for the floating point pixels).
+     * Box sums are widened as needed, so any Sigma is blurred without overflow.
+     */
     class FastGaussianBlur
     {
     public:
-        static const uint32_t MaxW = 10000;
-        template<uint8_t Passes, typename Pixel>
+        static const uint32_t StripSize = 4096; //< Column sums kept by the vertical pass at once (fits into L1)
+
+        /*!
+         * Intermediate is uint16_t for the integer pixels and float for the floating point ones if void.
+         */
+        template<uint8_t Passes, typename Intermediate = void, typename Pixel>
         static void Blur(GenericImage <Pixel> &Image, double Sigma);
+
+        /*!
+         * Blur every plane of the planar image separately (single-plant passes over contiguous rows).
+         */
+        template<uint8_t Passes, typename Intermediate = void, typename Pixel>
+        static void Blur(PlanarImage <Pixel> &Image, double Sigma);
+
+        /*!
+         * \return Distance in pixels the blur reaches in every direction, i.e. the halo needed to blur
+         * a tile of the image with the same result as the whole image.
+         */
+        template<uint8_t Passes>
+        static uint32_t GetRadius(double Sigma);
     private:
         template<uint8_t Passes>
         static void CalculateBoxSizes(double Sigma, uint32_t (&Sizes)[Passes]);
-        template<typename PixelSrc, typename PixelDst>
+
+        /*!
+         * Passes of Blur() with the box sums of the Sum type (wide enough for the largest box).
+         */
+        template<uint8_t Passes, typename Intermediate, typename Sum, typename Pixel>
+        static void Blur(GenericImage <Pixel> &Image, const uint32_t (&Sizes)[Passes], uint8_t Shift);
+
+        /*!
+         * Sums of the R pixels of the row accumulated in Accumulator and stored to HSum.
+         */
+        template<typename Accumulator, typename PixelSrc, typename PixelDst>
         static void HorizontalBlur(const GenericImage <PixelSrc> &Src, GenericImage <PixelDst> &HSum, uint32_t R);
-        template<typename PixelSrc, typename PixelDst>
-        static void VerticalBlur(const GenericImage <PixelSrc> &Src, GenericImage <PixelDst> &VSum, uint32_t R);
+
+        /*!
+         * Sums of the R rows of HSum accumulated in Accumulator and stored to VSum multiplied by S.
+         */
+        template<typename Accumulator, typename PixelSrc, typename PixelDst>
+        static void VerticalBlur(const GenericImage <PixelSrc> &Src, GenericImage <PixelDst> &VSum, uint32_t R,
+                                 double S);
+
+        /*!
+         * VerticalBlur() with the accumulator wide enough for the R * R sums of MaxMean (double if Float).
+         */
+        template<bool Float, typename PixelSrc, typename PixelDst>
+        static void VerticalBlur(const GenericImage <PixelSrc> &Src, GenericImage <PixelDst> &VSum, uint32_t R,
+                                 double S, double MaxMean);
+
+        /*!
+         * Row of the vertical pass: Sum += Down - Up for Count values (pUp or pDown is nullptr if the row is out
+         * of the image) and Dst = Sum * S.
+         */
+        template<typename Accumulator, typename SrcType, typename DstType>
+        static void VerticalRow(Accumulator *pSum, const SrcType *pUp, const SrcType *pDown, DstType *pDst,
+                                size_t Count, double S);
+
+        template<typename Accumulator, typename SrcType, typename DstType>
+        using VerticalRowFunction = void (*)(Accumulator *pSum, const SrcType *pUp, const SrcType *pDown,
+                                             DstType *pDst, size_t Count, double S);
+
+        template<typename Accumulator, typename SrcType, typename DstType>
+        static VerticalRowFunction<Accumulator, SrcType, DstType> SelectVerticalRow();
+
+#ifdef JIMLIB_HAS_X86_SIMD
+        /*!
+         * VerticalRow() compiled for AVX2 (the loops are vectorized by the compiler).
+         */
+        template<typename Accumulator, typename SrcType, typename DstType>
+        __attribute__((target("avx2")))
+        static void VerticalRowAVX2(Accumulator *pSum, const SrcType *pUp, const SrcType *pDown, DstType *pDst,
+                                    size_t Count, double S);
+#endif
+
+        /*!
+         * Intermediate Value to the pixel: Shift fraction bits are rounded off, floats are rounded to integers.
+         */
+        template<typename T, typename I>
+        static T ToPixel(I Value, uint8_t Shift);
     };
 
 // =======================================================
@@ -65,159 +150,325 @@ namespace jimlib
         }
     }
 
-    template<typename PixelSrc, typename PixelDst>
+    template<uint8_t Passes>
+    uint32_t FastGaussianBlur::GetRadius(double Sigma)
+    {
+        uint32_t Sizes[Passes];
+        CalculateBoxSizes(Sigma, Sizes);
+        uint32_t Radius = 0;
+        for (uint16_t i = 0; i < Passes; ++i)
+        {
+            Radius += (Sizes[i] - 1) / 2;
+        }
+        return Radius;
+    }
+
+    template<typename T, typename I>
+    T FastGaussianBlur::ToPixel(I Value, uint8_t Shift)
+    {
+        if (std::is_floating_point<I>::value)
+        {
+            return std::is_floating_point<T>::value ? (T) Value : (T) (Value + (I) 0.5);
+        }
+        return (T) ((Shift > 0) ? ((uint64_t) Value + (1ull << (Shift - 1))) >> Shift : (uint64_t) Value);
+    }
+
+    template<typename Accumulator, typename PixelSrc, typename PixelDst>
     void FastGaussianBlur::HorizontalBlur(const GenericImage <PixelSrc> &Src, GenericImage <PixelDst> &HSum, uint32_t R)
     {
+        const uint32_t Plants = GenericImage<PixelSrc>::Plants;
         uint32_t W = Src.GetWidth();
         uint32_t H = Src.GetHeight();
         uint32_t r = (R - 1) / 2;
+        // Interior: the box is inside the row, one pixel enters and one leaves it
+        uint32_t InteriorBegin = std::min(W, r + 1);
+        uint32_t InteriorEnd = std::max(InteriorBegin, (W > r) ? W - r : 0);
 
-        auto it_l = Src.begin();
-        auto it_r = Src.begin();
-        auto it_blur = HSum.begin();
-
-        for (uint32_t y = 0; y < H; ++y)
+        ThreadPool::GetDefault()->ParallelFor(0, H, [&](uint32_t First, uint32_t Last, uint32_t)
         {
-            uint32_t PartialSum[GenericImage<PixelSrc>::Plants];
-            memset(PartialSum, 0, sizeof(PartialSum));
-            for (uint32_t x = 0; x <= r; ++x, ++it_r)
+            for (uint32_t y = First; y < Last; ++y)
             {
-                for (uint16_t plant = 0; plant < GenericImage<PixelSrc>::Plants; ++plant)
+                const typename PixelSrc::Type *pSrc = *Src.GetRow(y);
+                typename PixelDst::Type *pDst = *HSum.GetRow(y);
+                Accumulator PartialSum[Plants];
+                std::fill(PartialSum, PartialSum + Plants, 0);
+                for (uint32_t x = 0; x <= r && x < W; ++x)
                 {
-                    PartialSum[plant] += it_r[plant];
+                    for (uint16_t plant = 0; plant < Plants; ++plant)
+                    {
+                        PartialSum[plant] += pSrc[(size_t) x * Plants + plant];
+                    }
                 }
-            }
-            for (uint16_t plant = 0; plant < GenericImage<PixelSrc>::Plants; ++plant)
-            {
-                it_blur[plant] = PartialSum[plant];
-            }
-            ++it_blur;
-            for (uint32_t x = r + 1; x <= R - 1; ++x, ++it_r, ++it_blur)
-            {
-                for (uint16_t plant = 0; plant < GenericImage<PixelSrc>::Plants; ++plant)
+                // Box of the pixel x is [x - r, x + r] clipped by the row
+                auto Border = [&](uint32_t x)
+                {
+                    for (uint16_t plant = 0; plant < Plants; ++plant)
+                    {
+                        if (x > 0 && x + r < W)
+                        {
+                            PartialSum[plant] += pSrc[(size_t) (x + r) * Plants + plant];
+                        }
+                        if (x > r)
+                        {
+                            PartialSum[plant] -= pSrc[(size_t) (x - r - 1) * Plants + plant];
+                        }
+                        pDst[(size_t) x * Plants + plant] = PartialSum[plant];
+                    }
+                };
+                for (uint32_t x = 0; x < InteriorBegin; ++x)
                 {
-                    PartialSum[plant] += it_r[plant];
-                    it_blur[plant] = PartialSum[plant];
+                    Border(x);
                 }
-            }
-            for (uint32_t x = R; x < W; ++x, ++it_r, ++it_l, ++it_blur)
-            {
-                for (uint16_t plant = 0; plant < GenericImage<PixelSrc>::Plants; ++plant)
+                for (uint32_t x = InteriorBegin; x < InteriorEnd; ++x)
                 {
-                    PartialSum[plant] = PartialSum[plant] - it_l[plant] + it_r[plant];
-                    it_blur[plant] = PartialSum[plant];
+                    const typename PixelSrc::Type *pDown = pSrc + (size_t) (x + r) * Plants;
+                    const typename PixelSrc::Type *pUp = pSrc + (size_t) (x - r - 1) * Plants;
+                    for (uint16_t plant = 0; plant < Plants; ++plant)
+                    {
+                        PartialSum[plant] = PartialSum[plant] - pUp[plant] + pDown[plant];
+                        pDst[(size_t) x * Plants + plant] = PartialSum[plant];
+                    }
                 }
-            }
-            for (uint32_t x = W - r; x < W; ++x, ++it_l, ++it_blur)
-            {
-                for (uint16_t plant = 0; plant < GenericImage<PixelSrc>::Plants; ++plant)
+                for (uint32_t x = InteriorEnd; x < W; ++x)
                 {
-                    PartialSum[plant] = PartialSum[plant] - it_l[plant];
-                    it_blur[plant] = PartialSum[plant];
+                    Border(x);
                 }
             }
-            it_l += (R - r);
-        }
+        }, 16384 / std::max(1u, W * Plants) + 1);
     }
 
-    template<typename PixelSrc, typename PixelDst>
-    void FastGaussianBlur::VerticalBlur(const GenericImage <PixelSrc> &Src, GenericImage <PixelDst> &VSum, uint32_t R)
+    template<typename Accumulator, typename PixelSrc, typename PixelDst>
+    void FastGaussianBlur::VerticalBlur(const GenericImage <PixelSrc> &Src, GenericImage <PixelDst> &VSum, uint32_t R,
+                                        double S)
     {
+        const uint32_t Plants = GenericImage<PixelSrc>::Plants;
         uint32_t W = Src.GetWidth();
         uint32_t H = Src.GetHeight();
-        assert(W <= MaxW);
-
         uint32_t r = (R - 1) / 2;
-        uint32_t PartialSum[GenericImage<PixelSrc>::Plants][MaxW];
-        memset(PartialSum, 0, sizeof(PartialSum));
-        double S = 1.0 / (R * R);
-
-        auto it_d = Src.begin();
-        auto it_u = Src.begin();
-        auto it_b = VSum.begin();
 
-        for (uint32_t y = 0; y <= r; ++y)
+        // Columns are blurred by strips, so the sums of the strip stay in L1 while the rows are streamed through.
+        // Strips are blurred in parallel, every worker gets at least one if the image is wide enough.
+        uint32_t Workers = ThreadPool::GetDefault()->GetWorkers();
+        uint32_t Strip = std::max(1u, StripSize / Plants);
+        Strip = std::min(Strip, std::max(64u, (W + Workers - 1) / Workers));
+        uint32_t Strips = (W + Strip - 1) / Strip;
+        auto Row = SelectVerticalRow<Accumulator, typename PixelSrc::Type, typename PixelDst::Type>();
+        ThreadPool::GetDefault()->ParallelFor(0, Strips, [&](uint32_t First, uint32_t Last, uint32_t)
         {
-            for (uint32_t x = 0; x < W; ++x, ++it_d)
+            std::vector<Accumulator> PartialSum((size_t) std::min(W, Strip) * Plants);
+            Accumulator *pSum = PartialSum.data();
+            for (uint32_t x = First * Strip; x < W && x < Last * Strip; x += Strip)
             {
-                for (uint16_t plant = 0; plant < GenericImage<PixelSrc>::Plants; ++plant)
+                size_t Offset = (size_t) x * Plants;
+                size_t Count = (size_t) std::min(Strip, W - x) * Plants;
+                std::fill(PartialSum.begin(), PartialSum.end(), 0);
+                for (uint32_t y = 0; y <= r && y < H; ++y)
                 {
-                    PartialSum[plant][x] += it_d[plant];
+                    const typename PixelSrc::Type *pDown = *Src.GetRow(y) + Offset;
+                    for (size_t i = 0; i < Count; ++i)
+                    {
+                        pSum[i] += pDown[i];
+                    }
+                }
+                for (uint32_t y = 0; y < H; ++y)
+                {
+                    // Window of the row y is [y - r, y + r] clipped by the image
+                    const typename PixelSrc::Type *pDown = (y > 0 && y + r < H) ? *Src.GetRow(y + r) + Offset : nullptr;
+                    const typename PixelSrc::Type *pUp = (y > r) ? *Src.GetRow(y - r - 1) + Offset : nullptr;
+                    Row(pSum, pUp, pDown, *VSum.GetRow(y) + Offset, Count, S);
                 }
             }
+        });
+    }
+
+    template<bool Float, typename PixelSrc, typename PixelDst>
+    void FastGaussianBlur::VerticalBlur(const GenericImage <PixelSrc> &Src, GenericImage <PixelDst> &VSum, uint32_t R,
+                                        double S, double MaxMean)
+    {
+        if (Float)
+        {
+            VerticalBlur<double>(Src, VSum, R, S);
         }
-        for (uint32_t x = 0; x < W; ++x, ++it_b)
+        else if ((double) R * R * MaxMean <= std::numeric_limits<uint32_t>::max())
+        {
+            VerticalBlur<uint32_t>(Src, VSum, R, S);
+        }
+        else
+        {
+            VerticalBlur<uint64_t>(Src, VSum, R, S);
+        }
+    }
+
+    template<typename Accumulator, typename SrcType, typename DstType>
+    void FastGaussianBlur::VerticalRow(Accumulator *pSum, const SrcType *pUp, const SrcType *pDown, DstType *pDst,
+                                       size_t Count, double S)
+    {
+        if (pUp != nullptr && pDown != nullptr)
         {
-            for (uint16_t plant = 0; plant < GenericImage<PixelSrc>::Plants; ++plant)
+            for (size_t i = 0; i < Count; ++i)
             {
-                it_b[plant] = PartialSum[plant][x] * S;
+                pSum[i] = pSum[i] - pUp[i] + pDown[i];
+                pDst[i] = pSum[i] * S;
             }
+            return;
         }
-        for (uint32_t y = r + 1; y <= R - 1; ++y)
+        for (size_t i = 0; i < Count; ++i)
         {
-            for (uint32_t x = 0; x < W; ++x, ++it_d, ++it_b)
+            pSum[i] += (pDown != nullptr) ? pDown[i] : 0;
+            pSum[i] -= (pUp != nullptr) ? pUp[i] : 0;
+            pDst[i] = pSum[i] * S;
+        }
+    }
+
+    template<typename Accumulator, typename SrcType, typename DstType>
+    FastGaussianBlur::VerticalRowFunction<Accumulator, SrcType, DstType> FastGaussianBlur::SelectVerticalRow()
+    {
+#ifdef JIMLIB_HAS_X86_SIMD
+        if (CpuFeatures::Has(CpuFeature::AVX2))
+        {
+            return &VerticalRowAVX2<Accumulator, SrcType, DstType>;
+        }
+#endif
+        return &VerticalRow<Accumulator, SrcType, DstType>;
+    }
+
+#ifdef JIMLIB_HAS_X86_SIMD
+    template<typename Accumulator, typename SrcType, typename DstType>
+    __attribute__((target("avx2")))
+    void FastGaussianBlur::VerticalRowAVX2(Accumulator *pSum, const SrcType *pUp, const SrcType *pDown, DstType *pDst,
+                                           size_t Count, double S)
+    {
+        // Same loops as VerticalRow(), vectorized by the compiler with the 256 bit registers
+        if (pUp != nullptr && pDown != nullptr)
+        {
+            for (size_t i = 0; i < Count; ++i)
             {
-                for (uint16_t plant = 0; plant < GenericImage<PixelSrc>::Plants; ++plant)
-                {
-                    PartialSum[plant][x] += it_d[plant];
-                    it_b[plant] = PartialSum[plant][x] * S;
-                }
+                pSum[i] = pSum[i] - pUp[i] + pDown[i];
+                pDst[i] = pSum[i] * S;
             }
+            return;
         }
-        for (uint32_t y = R; y < H; ++y)
+        for (size_t i = 0; i < Count; ++i)
         {
-            for (uint32_t x = 0; x < W; ++x, ++it_d, ++it_u, ++it_b)
+            pSum[i] += (pDown != nullptr) ? pDown[i] : 0;
+            pSum[i] -= (pUp != nullptr) ? pUp[i] : 0;
+            pDst[i] = pSum[i] * S;
+        }
+    }
+#endif
+
+    template<uint8_t Passes, typename Intermediate, typename Sum, typename Pixel>
+    void FastGaussianBlur::Blur(GenericImage <Pixel> &Image, const uint32_t (&Sizes)[Passes], uint8_t Shift)
+    {
+        const uint8_t Plants = GenericImage<Pixel>::Plants;
+        const bool Float = std::is_floating_point<Intermediate>::value;
+        typedef typename std::conditional<Float, double,
+                typename std::conditional<(sizeof(Sum) > 4), uint64_t, uint32_t>::type>::type HorizontalAccumulator;
+        GenericImage<GenericPixel<Sum, Plants>> HSum;
+        GenericImage<GenericPixel<Intermediate, Plants>> VSum;
+
+        uint32_t W = Image.GetWidth();
+        uint32_t H = Image.GetHeight();
+        HSum.Create(W, H);
+        // Means without the fraction bits are the same in the pixels, so the passes go through the image itself
+        bool InPlace = (Shift == 0 && Float == std::is_floating_point<typename Pixel::Type>::value);
+        if (!InPlace)
+        {
+            VSum.Create(W, H);
+        }
+
+        // Largest vertical sum of the pass is R * R * (the largest mean)
+        double MaxMean = Float ? 0 : (double) ((uint64_t) std::numeric_limits<typename Pixel::Type>::max() << Shift);
+        for (uint16_t pass = 0; pass < Passes; ++pass)
+        {
+            uint32_t R = Sizes[pass];
+            double S = ((pass == 0) ? (double) (1u << Shift) : 1.0) / ((double) R * R);
+            if (pass == 0 || InPlace)
             {
-                for (uint16_t plant = 0; plant < GenericImage<PixelSrc>::Plants; ++plant)
-                {
-                    PartialSum[plant][x] = PartialSum[plant][x] - it_u[plant] + it_d[plant];
-                    it_b[plant] = PartialSum[plant][x] * S;
-                }
+                HorizontalBlur<HorizontalAccumulator>(Image, HSum, R);
+            }
+            else
+            {
+                HorizontalBlur<HorizontalAccumulator>(VSum, HSum, R);
+            }
+            if (InPlace)
+            {
+                VerticalBlur<Float>(HSum, Image, R, S, MaxMean);
+            }
+            else
+            {
+                VerticalBlur<Float>(HSum, VSum, R, S, MaxMean);
             }
         }
-        for (uint32_t y = H - r; y < H; ++y)
+        if (InPlace)
         {
-            for (uint32_t x = 0; x < W; ++x, ++it_u, ++it_b)
+            return;
+        }
+
+        ThreadPool::GetDefault()->ParallelFor(0, H, [&](uint32_t First, uint32_t Last, uint32_t)
+        {
+            for (uint32_t y = First; y < Last; ++y)
             {
-                for (uint16_t plant = 0; plant < GenericImage<PixelSrc>::Plants; ++plant)
+                const Intermediate *pSrc = *VSum.GetRow(y);
+                typename Pixel::Type *pDst = *Image.GetRow(y);
+                for (size_t i = 0; i < (size_t) W * Plants; ++i)
                 {
-                    PartialSum[plant][x] = PartialSum[plant][x] - it_u[plant];
-                    it_b[plant] = PartialSum[plant][x] * S;
+                    pDst[i] = ToPixel<typename Pixel::Type>(pSrc[i], Shift);
                 }
             }
-        }
+        }, 16384 / std::max(1u, W * Plants) + 1);
     }
 
-    template<uint8_t Passes, typename Pixel>
+    template<uint8_t Passes, typename Intermediate, typename Pixel>
     void FastGaussianBlur::Blur(GenericImage <Pixel> &Image, double Sigma)
     {
-        GenericImage<GenericPixel<uint16_t, GenericImage<Pixel>::Plants>> HSum;
-        GenericImage<GenericPixel<uint16_t, GenericImage<Pixel>::Plants>> VSum;
+        typedef typename Pixel::Type Type;
+        typedef typename std::conditional<!std::is_void<Intermediate>::value, Intermediate,
+                typename std::conditional<std::is_floating_point<Type>::value, float, uint16_t>::type>::type Means;
+        static_assert(std::is_same<Means, uint16_t>::value || std::is_same<Means, uint32_t>::value
+                      || std::is_same<Means, float>::value, "Intermediate should be uint16_t, uint32_t or float.");
+        static_assert(std::is_floating_point<Means>::value
+                      || (std::is_integral<Type>::value && sizeof(Type) <= 2),
+                      "Integer intermediates support only 8 and 16 bit pixels.");
 
         uint32_t Sizes[Passes];
-        uint32_t W = Image.GetWidth();
-        uint32_t H = Image.GetHeight();
-        HSum.Create(W, H);
-        VSum.Create(W, H);
         CalculateBoxSizes(Sigma, Sizes);
-
-        HorizontalBlur(Image, HSum, Sizes[0]);
-        VerticalBlur(HSum, VSum, Sizes[0]);
-
-        for (uint16_t pass = 1; pass < Passes; ++pass)
+        uint32_t MaxR = *std::max_element(Sizes, Sizes + Passes);
+        // uint32_t means keep 8 fraction bits (up to 24 bits of the value)
+        uint8_t Shift = std::is_same<Means, uint32_t>::value ? 8 : 0;
+        if (std::is_floating_point<Means>::value)
+        {
+            Blur<Passes, Means, float>(Image, Sizes, 0);
+            return;
+        }
+        // Horizontal sums are R means: 16 bit while they fit, then 32 bit, 64 bit for the fixed-point 16 bit pixels
+        uint64_t MaxSum = (uint64_t) MaxR * ((uint64_t) std::numeric_limits<Type>::max() << Shift);
+        if (MaxSum <= std::numeric_limits<uint16_t>::max())
+        {
+            Blur<Passes, Means, uint16_t>(Image, Sizes, Shift);
+        }
+        else if (MaxSum <= std::numeric_limits<uint32_t>::max())
+        {
+            Blur<Passes, Means, uint32_t>(Image, Sizes, Shift);
+        }
+        else
         {
-            HorizontalBlur(VSum, HSum, Sizes[pass]);
-            VerticalBlur(HSum, VSum, Sizes[pass]);
+            Blur<Passes, Means, uint64_t>(Image, Sizes, Shift);
         }
+    }
 
-        auto it_src = VSum.begin();
-        auto it_dst = Image.begin();
-        for (; it_src != VSum.end(); ++it_src, ++it_dst)
+    template<uint8_t Passes, typename Intermediate, typename Pixel>
+    void FastGaussianBlur::Blur(PlanarImage <Pixel> &Image, double Sigma)
+    {
+        // There are no views over the planes of the empty image
+        if (Image.GetWidth() == 0 || Image.GetHeight() == 0)
         {
-            for (uint16_t p = 0; p < GenericImage<Pixel>::Plants; ++p)
-            {
-                it_dst[p] = it_src[p];
-            }
+            return;
+        }
+        for (uint8_t p = 0; p < PlanarImage<Pixel>::Plants; ++p)
+        {
+            GenericImageView<typename PlanarImage<Pixel>::PlanePixel> Plane = Image.GetPlane(p);
+            Blur<Passes, Intermediate>(Plane, Sigma);
         }
     }
 };
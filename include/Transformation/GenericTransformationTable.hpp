@@ -27,17 +27,20 @@
 #define JIMLIB_GENERICTRANSFORMATIONTABLE_HPP
 
 #include "Image/GenericImage.hpp"
+#include "Utils/ThreadPool.hpp"
 
 namespace jimlib
 {
-    class CoordsXY16 : public GenericPixel<uint32_t, 2>
+    class CoordsXY16 : public PixelValue<uint32_t, 2>
     {
     public:
-        CoordsXY16();
-        CoordsXY16(uint32_t X, uint32_t Y);
-        CoordsXY16(const CoordsXY16 &Coords);
-        uint32_t &X;
-        uint32_t &Y;
+        typedef CoordsXY16 ValueType;
+        constexpr CoordsXY16();
+        constexpr CoordsXY16(uint32_t X, uint32_t Y);
+        uint32_t &X();
+        const uint32_t &X() const;
+        uint32_t &Y();
+        const uint32_t &Y() const;
     };
 
     namespace InterpolationType
@@ -52,26 +55,34 @@ namespace jimlib
         void Apply(const GenericImage<Pixel> &Src, GenericImage<Pixel> &Dst) const;
     };
 
-    inline CoordsXY16::CoordsXY16()
-            : X(m_Buffer[0]),
-              Y(m_Buffer[1])
+    constexpr CoordsXY16::CoordsXY16()
+            : PixelValue<uint32_t, 2>()
     {
     }
 
-    inline CoordsXY16::CoordsXY16(uint32_t _X, uint32_t _Y)
-            : X(m_Buffer[0]),
-              Y(m_Buffer[1])
+    constexpr CoordsXY16::CoordsXY16(uint32_t _X, uint32_t _Y)
+            : PixelValue<uint32_t, 2>(_X, _Y)
     {
-        X = _X;
-        Y = _Y;
     }
 
-    inline CoordsXY16::CoordsXY16(const CoordsXY16 &Coords)
-            : X(m_Buffer[0]),
-              Y(m_Buffer[1])
+    inline uint32_t &CoordsXY16::X()
     {
-        X = Coords.X;
-        Y = Coords.Y;
+        return m_Buffer[0];
+    }
+
+    inline const uint32_t &CoordsXY16::X() const
+    {
+        return m_Buffer[0];
+    }
+
+    inline uint32_t &CoordsXY16::Y()
+    {
+        return m_Buffer[1];
+    }
+
+    inline const uint32_t &CoordsXY16::Y() const
+    {
+        return m_Buffer[1];
     }
 
     template<uint32_t Interpolation, typename Pixel>
@@ -85,29 +96,31 @@ namespace jimlib
         uint32_t sx = 0;
         uint32_t sy = 0;
         uint32_t ex = Dst.GetWidth();
-        uint32_t ey = Dst.GetHeight();
 
-        for (unsigned int y = sy; y < ey; ++y)
+        ParallelRows(Dst, [&](uint32_t First, uint32_t Last, uint32_t)
         {
-            typename GenericImage<Pixel>::iterator it_dst = Dst.GetColRow(sx, y);
-            GenericTransformationTable::const_iterator it_src = GetColRow(sx, y);
-            for (unsigned int x = sx; x < ex; ++x, ++it_dst, ++it_src)
+            for (unsigned int y = sy + First; y < sy + Last; ++y)
             {
-                for (unsigned int p = 0; p < GenericImage<Pixel>::Plants; ++p)
+                typename GenericImage<Pixel>::iterator it_dst = Dst.GetColRow(sx, y);
+                GenericTransformationTable::const_iterator it_src = GetColRow(sx, y);
+                for (unsigned int x = sx; x < ex; ++x, ++it_dst, ++it_src)
                 {
-                    switch(Interpolation)
+                    for (unsigned int p = 0; p < GenericImage<Pixel>::Plants; ++p)
                     {
-                        case InterpolationType::NearestNeighbour :
-                            {
-                                it_dst[p] = Src.GetPixel(it_src[0], it_src[1], p);
-                            }
-                            break;
-                        default:
-                            break;
+                        switch(Interpolation)
+                        {
+                            case InterpolationType::NearestNeighbour :
+                                {
+                                    it_dst[p] = Src.GetPixel(it_src[0], it_src[1], p);
+                                }
+                                break;
+                            default:
+                                break;
+                        }
                     }
                 }
             }
-        }
+        });
     };
 };
 
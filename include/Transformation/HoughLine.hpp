@@ -29,6 +29,7 @@
 #include <cmath>
 #include "Image/PixelTypes.hpp"
 #include "Image/BinaryImage.hpp"
+#include "Image/ImageExpression.hpp"
 #include "Utils/Search.hpp"
 
 namespace jimlib
@@ -36,7 +37,7 @@ namespace jimlib
     class HoughLine : public GenericImage<PixelType::Mono32>
     {
     public:
-        void Calculate(const BinaryImage &Src, float min_angle, float max_angle, float angle_step, float min_distance, float max_distance, float distance_step, int32_t norm = 0);
+        void Calculate(const GenericImage<PixelType::Mono8> &Src, float min_angle, float max_angle, float angle_step, float min_distance, float max_distance, float distance_step, int32_t norm = 0);
     private:
         float deg2rad(float angle);
     };
@@ -46,7 +47,7 @@ namespace jimlib
         return (angle*M_PI/180.0);
     }
     
-    void HoughLine::Calculate(const BinaryImage &Src, float min_angle, float max_angle, float angle_step, float min_distance, float max_distance, float distance_step, int32_t norm)
+    void HoughLine::Calculate(const GenericImage<PixelType::Mono8> &Src, float min_angle, float max_angle, float angle_step, float min_distance, float max_distance, float distance_step, int32_t norm)
     {
         assert(max_angle > min_angle);
         assert(max_distance > min_distance);
@@ -82,10 +83,7 @@ namespace jimlib
             int32_t max_ = max(*this);
             if (max_ > 0)
             {
-                for (auto it = this->begin(); it != this->end(); ++it)
-                {
-                    it[0] = (norm * it[0] / max_);
-                }
+                Evaluate(*this, norm * (*this) / max_);
             }
         }
     }
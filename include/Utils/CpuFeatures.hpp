@@ -0,0 +1,138 @@
+/*
+ *  jimlib -- generic image and-image algorithms library
+ *  Copyright (C) 2015 Alexey Titov
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty.  In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ *
+ *  Alexey Titov
+ *  alex.justes@gmail.com
+ *  https://github.com/alex-justes/jimlib
+ */
+
+#ifndef JIMLIB_CPUFEATURES_HPP
+#define JIMLIB_CPUFEATURES_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#include <immintrin.h>
+#define JIMLIB_HAS_X86_SIMD 1
+#endif
+
+namespace jimlib
+{
+    namespace CpuFeature
+    {
+        const uint32_t SSSE3 = 1;
+        const uint32_t SSE41 = 2;
+        const uint32_t AVX2 = 4;
+        const uint32_t All = 0xFFFFFFFF;
+    };
+
+    /*!
+     * Instruction sets available at runtime (cpuid), used to select SIMD kernels.
+     *
+     * Kernels are compiled with target attributes, so the library itself is built without any -m flags
+     * and the same binary runs on every x86 CPU. On other architectures no feature is reported
+     * and the scalar code is used.
+     */
+    class CpuFeatures
+    {
+    public:
+        /*!
+         * \return true if Feature is supported by the CPU and OS and isn't disabled by SetMask().
+         */
+        static bool Has(uint32_t Feature);
+
+        /*!
+         * \return Supported and enabled features (CpuFeature flags).
+         */
+        static uint32_t Get();
+
+        /*!
+         * Restrict the features used by the kernels, e.g. SetMask(0) to force the scalar code
+         * to compare it with SIMD versions. CpuFeature::All restores the defaults.
+         */
+        static void SetMask(uint32_t Mask);
+    private:
+        static uint32_t Detect();
+        static std::atomic<uint32_t> &Enabled();
+    };
+
+// =======================================================
+
+    inline uint32_t CpuFeatures::Detect()
+    {
+        uint32_t Features = 0;
+#ifdef JIMLIB_HAS_X86_SIMD
+        unsigned int a = 0, b = 0, c = 0, d = 0;
+        if (__get_cpuid(1, &a, &b, &c, &d) == 0)
+        {
+            return 0;
+        }
+        if (c & bit_SSSE3)
+        {
+            Features |= CpuFeature::SSSE3;
+        }
+        if (c & bit_SSE4_1)
+        {
+            Features |= CpuFeature::SSE41;
+        }
+        bool OsAvx = false;
+        if ((c & bit_OSXSAVE) && (c & bit_AVX))
+        {
+            // YMM state should be enabled by OS
+            uint32_t Lo = 0, Hi = 0;
+            __asm__ __volatile__("xgetbv" : "=a"(Lo), "=d"(Hi) : "c"(0));
+            OsAvx = ((Lo & 6) == 6);
+        }
+        if (OsAvx && __get_cpuid_max(0, nullptr) >= 7)
+        {
+            __cpuid_count(7, 0, a, b, c, d);
+            if (b & bit_AVX2)
+            {
+                Features |= CpuFeature::AVX2;
+            }
+        }
+#endif
+        return Features;
+    }
+
+    inline std::atomic<uint32_t> &CpuFeatures::Enabled()
+    {
+        static std::atomic<uint32_t> Features(Detect());
+        return Features;
+    }
+
+    inline uint32_t CpuFeatures::Get()
+    {
+        return Enabled();
+    }
+
+    inline bool CpuFeatures::Has(uint32_t Feature)
+    {
+        return (Get() & Feature) == Feature;
+    }
+
+    inline void CpuFeatures::SetMask(uint32_t Mask)
+    {
+        Enabled() = Detect() & Mask;
+    }
+};
+#endif //JIMLIB_CPUFEATURES_HPP
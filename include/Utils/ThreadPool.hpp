@@ -0,0 +1,378 @@
+/*
+ *  jimlib -- generic image and-image algorithms library
+ *  Copyright (C) 2015 Alexey Titov
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty.  In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ *
+ *  Alexey Titov
+ *  alex.justes@gmail.com
+ *  https://github.com/alex-justes/jimlib
+ */
+
+#ifndef JIMLIB_THREADPOOL_HPP
+#define JIMLIB_THREADPOOL_HPP
+
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Image/GenericImage.hpp"
+namespace jimlib
+{
+    /*!
+     * Small pool of worker threads for the row-parallel kernels.
+     *
+     * Work is split statically: ParallelFor() gives every worker one contiguous range, which depends only on
+     * the range and the amount of workers, so results are deterministic. The calling thread works as worker 0.
+     * Calls from inside of a job (nested parallelism) are executed serially in the calling thread.
+     * If the job throws, Execute() and ParallelFor() wait for all of the workers and rethrow the first exception.
+     *
+     * Algorithms use the pool returned by ThreadPool::GetDefault(). By default it has one worker per
+     * hardware thread, use SetWorkers() or SetDefault() to change it (1 worker means no threads at all).
+     * Every call takes the amount of workers once, so a concurrent SetWorkers() doesn't break a running one,
+     * but scratch sized from GetWorkers() in advance is valid only while the pool isn't resized.
+     */
+    class ThreadPool
+    {
+    public:
+        typedef std::function<void(uint32_t Worker)> Job;
+        typedef std::function<void(uint32_t First, uint32_t Last, uint32_t Worker)> RangeJob;
+
+        /*!
+         * \param[in] Workers Amount of workers including the calling thread, 0 - one per hardware thread.
+         */
+        explicit ThreadPool(uint32_t Workers = 0);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        uint32_t GetWorkers() const;
+
+        /*!
+         * Restart the pool with the given amount of workers (0 - one per hardware thread).
+         * Waits for the running Execute(). It should not race with the code which sized per-worker scratch
+         * from GetWorkers().
+         */
+        void SetWorkers(uint32_t Workers);
+
+        /*!
+         * Call Function(Worker) for every Worker in [0, GetWorkers()) in parallel and wait for all of them.
+         * The first exception thrown by any of the workers is rethrown after all of them have finished.
+         */
+        void Execute(const Job &Function);
+
+        /*!
+         * Split [First, Last) into at most GetWorkers() contiguous ranges of at least MinChunk items
+         * and call Function(Begin, End, Worker) for each of them in parallel.
+         */
+        void ParallelFor(uint32_t First, uint32_t Last, const RangeJob &Function, uint32_t MinChunk = 1);
+
+        /*!
+         * \return Pool used by the algorithms.
+         */
+        static ThreadPool *GetDefault();
+
+        /*!
+         * Set pool used by the algorithms. It should outlive its usage, nullptr restores the built-in pool.
+         */
+        static void SetDefault(ThreadPool *pPool);
+    private:
+        /*!
+         * Marks the calling thread as running a job for its lifetime (restores the previous state).
+         */
+        class JobScope
+        {
+        public:
+            JobScope();
+            ~JobScope();
+        private:
+            bool m_Previous;
+        };
+
+        typedef std::function<void(uint32_t Worker, uint32_t Workers)> WorkerJob;
+
+        /*!
+         * Call Function(Worker, Workers) for every Worker in [0, Workers) with the amount of workers taken once.
+         */
+        void Dispatch(const WorkerJob &Function);
+        void Start(uint32_t Workers);
+        void Stop();
+        void WorkerLoop(uint32_t Worker, uint64_t Generation);
+        static bool &InsideJob();
+        static ThreadPool *BuiltInInstance();
+        static std::atomic<ThreadPool *> &DefaultInstance();
+
+        std::vector<std::thread> m_Threads; //< Workers 1..N-1
+        std::mutex m_ExecuteMutex; //< One Execute() at a time
+        std::mutex m_Mutex; //< Guards the job state below
+        std::condition_variable m_Wake;
+        std::condition_variable m_Done;
+        const Job *m_pJob; //< Current job
+        uint64_t m_Generation; //< Incremented for every job
+        uint32_t m_Pending; //< Workers still running the current job
+        std::exception_ptr m_Error; //< First exception thrown by the current job
+        std::atomic<uint32_t> m_Workers; //< Amount of workers including the calling thread
+        bool m_Stop;
+    };
+
+    /*!
+     * Run Function(FirstRow, LastRow, Worker) over the rows of the Image in parallel on the default pool.
+     * Small images are split into fewer ranges, so threads are not woken up for a few pixels.
+     */
+    template<typename Pixel>
+    void ParallelRows(const GenericImage<Pixel> &Image, const ThreadPool::RangeJob &Function);
+
+// =======================================================
+
+    inline ThreadPool::ThreadPool(uint32_t Workers)
+            : m_pJob(nullptr),
+              m_Generation(0),
+              m_Pending(0),
+              m_Workers(1),
+              m_Stop(false)
+    {
+        Start(Workers);
+    }
+
+    inline ThreadPool::~ThreadPool()
+    {
+        Stop();
+    }
+
+    inline uint32_t ThreadPool::GetWorkers() const
+    {
+        return m_Workers;
+    }
+
+    inline void ThreadPool::SetWorkers(uint32_t Workers)
+    {
+        std::lock_guard<std::mutex> Execute(m_ExecuteMutex);
+        Stop();
+        Start(Workers);
+    }
+
+    inline void ThreadPool::Start(uint32_t Workers)
+    {
+        if (Workers == 0)
+        {
+            Workers = std::max(1u, std::thread::hardware_concurrency());
+        }
+        m_Stop = false;
+        m_Workers = Workers;
+        for (uint32_t w = 1; w < Workers; ++w)
+        {
+            m_Threads.push_back(std::thread(&ThreadPool::WorkerLoop, this, w, m_Generation));
+        }
+    }
+
+    inline void ThreadPool::Stop()
+    {
+        {
+            std::lock_guard<std::mutex> Lock(m_Mutex);
+            m_Stop = true;
+        }
+        m_Wake.notify_all();
+        for (size_t i = 0; i < m_Threads.size(); ++i)
+        {
+            m_Threads[i].join();
+        }
+        m_Threads.clear();
+        m_Workers = 1;
+    }
+
+    inline void ThreadPool::WorkerLoop(uint32_t Worker, uint64_t Generation)
+    {
+        InsideJob() = true;
+        std::unique_lock<std::mutex> Lock(m_Mutex);
+        for (;;)
+        {
+            m_Wake.wait(Lock, [this, Generation]() { return m_Stop || m_Generation != Generation; });
+            if (m_Stop)
+            {
+                return;
+            }
+            Generation = m_Generation;
+            const Job *pJob = m_pJob;
+            Lock.unlock();
+            std::exception_ptr Error;
+            try
+            {
+                (*pJob)(Worker);
+            }
+            catch (...)
+            {
+                Error = std::current_exception();
+            }
+            Lock.lock();
+            if (Error && !m_Error)
+            {
+                m_Error = Error;
+            }
+            if (--m_Pending == 0)
+            {
+                m_Done.notify_one();
+            }
+        }
+    }
+
+    inline void ThreadPool::Execute(const Job &Function)
+    {
+        Dispatch([&](uint32_t Worker, uint32_t)
+                 {
+                     Function(Worker);
+                 });
+    }
+
+    inline void ThreadPool::Dispatch(const WorkerJob &Function)
+    {
+        if (InsideJob())
+        {
+            uint32_t Workers = m_Workers;
+            for (uint32_t w = 0; w < Workers; ++w)
+            {
+                Function(w, Workers);
+            }
+            return;
+        }
+        // SetWorkers() can't change the amount of workers until the job is done
+        std::unique_lock<std::mutex> Execute(m_ExecuteMutex);
+        uint32_t Workers = m_Workers;
+        if (Workers <= 1)
+        {
+            // No threads to wait for, nested calls lock again
+            Execute.unlock();
+            Function(0, 1);
+            return;
+        }
+        Job Bound = [&](uint32_t Worker)
+        {
+            Function(Worker, Workers);
+        };
+        {
+            std::lock_guard<std::mutex> Lock(m_Mutex);
+            m_pJob = &Bound;
+            m_Pending = Workers - 1;
+            ++m_Generation;
+        }
+        m_Wake.notify_all();
+        std::exception_ptr Error;
+        try
+        {
+            JobScope Scope;
+            Function(0, Workers);
+        }
+        catch (...)
+        {
+            Error = std::current_exception();
+        }
+        // Workers use the Function until they are done, even if this one has failed
+        std::unique_lock<std::mutex> Lock(m_Mutex);
+        if (Error && !m_Error)
+        {
+            m_Error = Error;
+        }
+        m_Done.wait(Lock, [this]() { return m_Pending == 0; });
+        m_pJob = nullptr;
+        Error = m_Error;
+        m_Error = nullptr;
+        Lock.unlock();
+        if (Error)
+        {
+            std::rethrow_exception(Error);
+        }
+    }
+
+    inline void ThreadPool::ParallelFor(uint32_t First, uint32_t Last, const RangeJob &Function, uint32_t MinChunk)
+    {
+        if (Last <= First)
+        {
+            return;
+        }
+        uint64_t Count = Last - First;
+        MinChunk = std::max(1u, MinChunk);
+        uint64_t MaxChunks = (Count + MinChunk - 1) / MinChunk;
+        if (MaxChunks <= 1)
+        {
+            Function(First, Last, 0);
+            return;
+        }
+        // Split is made for the same amount of workers the job is run with
+        Dispatch([&](uint32_t Worker, uint32_t Workers)
+                 {
+                     uint32_t Chunks = (uint32_t) std::min<uint64_t>(Workers, MaxChunks);
+                     if (Worker < Chunks)
+                     {
+                         uint32_t Begin = First + (uint32_t) (Count * Worker / Chunks);
+                         uint32_t End = First + (uint32_t) (Count * (Worker + 1) / Chunks);
+                         Function(Begin, End, Worker);
+                     }
+                 });
+    }
+
+    inline ThreadPool::JobScope::JobScope()
+            : m_Previous(InsideJob())
+    {
+        InsideJob() = true;
+    }
+
+    inline ThreadPool::JobScope::~JobScope()
+    {
+        InsideJob() = m_Previous;
+    }
+
+    inline bool &ThreadPool::InsideJob()
+    {
+        static thread_local bool Inside = false;
+        return Inside;
+    }
+
+    inline ThreadPool *ThreadPool::BuiltInInstance()
+    {
+        static ThreadPool Pool;
+        return &Pool;
+    }
+
+    inline std::atomic<ThreadPool *> &ThreadPool::DefaultInstance()
+    {
+        static std::atomic<ThreadPool *> pDefault(BuiltInInstance());
+        return pDefault;
+    }
+
+    inline ThreadPool *ThreadPool::GetDefault()
+    {
+        return DefaultInstance();
+    }
+
+    inline void ThreadPool::SetDefault(ThreadPool *pPool)
+    {
+        DefaultInstance() = (pPool != nullptr) ? pPool : BuiltInInstance();
+    }
+
+    template<typename Pixel>
+    void ParallelRows(const GenericImage<Pixel> &Image, const ThreadPool::RangeJob &Function)
+    {
+        // At least ~16K pixels per range.
+        uint32_t MinRows = 16384 / std::max(1u, Image.GetWidth()) + 1;
+        ThreadPool::GetDefault()->ParallelFor(0, Image.GetHeight(), Function, MinRows);
+    }
+};
+#endif //JIMLIB_THREADPOOL_HPP
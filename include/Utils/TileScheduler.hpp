@@ -0,0 +1,277 @@
+/*
+ *  jimlib -- generic image and-image algorithms library
+ *  Copyright (C) 2015 Alexey Titov
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty.  In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ *
+ *  Alexey Titov
+ *  alex.justes@gmail.com
+ *  https://github.com/alex-justes/jimlib
+ */
+
+#ifndef JIMLIB_TILESCHEDULER_HPP
+#define JIMLIB_TILESCHEDULER_HPP
+
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "Image/GenericImage.hpp"
+#include "Image/GenericImageView.hpp"
+#include "Utils/Rect.hpp"
+#include "Utils/ThreadPool.hpp"
+namespace jimlib
+{
+    /*!
+     * Splits the image into tiles and processes them on the ThreadPool with work stealing.
+     *
+     * Every worker starts with its own contiguous block of tiles (row-major, so neighbour tiles share
+     * the halo rows in cache) and takes tiles from the front of it. When it's empty the worker steals
+     * from the back of the other workers' blocks, so all workers are busy until the very last tile.
+     */
+    class TileScheduler
+    {
+    public:
+        typedef std::function<void(const Rect<uint32_t> &Tile, uint32_t Worker)> TileJob;
+
+        /*!
+         * \param[in] TileWidth Width of the tile
+         * \param[in] TileHeight Height of the tile
+         * \param[in] pPool Pool to run on, nullptr - ThreadPool::GetDefault() at the moment of Run()
+         */
+        TileScheduler(uint32_t TileWidth = 256, uint32_t TileHeight = 256, ThreadPool *pPool = nullptr);
+
+        /*!
+         * Call Function(Tile, Worker) for every tile of the WidthXHeight image and wait for all of them.
+         * Tile is inclusive (see Rect), tiles at the right and bottom edges could be smaller.
+         */
+        void Run(uint32_t Width, uint32_t Height, const TileJob &Function);
+
+        /*!
+         * \return Amount of workers of the pool used by Run().
+         */
+        uint32_t GetWorkers() const;
+
+        /*!
+         * \return Tile grown by Halo pixels in every direction and clamped to the WidthXHeight image.
+         */
+        static Rect<uint32_t> Expand(const Rect<uint32_t> &Tile, uint32_t Halo, uint32_t Width, uint32_t Height);
+    private:
+        struct TileQueue
+        {
+            std::mutex Mutex;
+            std::deque<uint32_t> Tiles;
+        };
+        static bool Pop(TileQueue &Queue, uint32_t &Tile);
+        static bool Steal(std::vector<TileQueue> &Queues, uint32_t Worker, uint32_t &Tile);
+        ThreadPool *GetPool() const;
+
+        uint32_t m_TileWidth;
+        uint32_t m_TileHeight;
+        ThreadPool *m_pPool;
+    };
+
+    /*!
+     * Runs a chain of local stages tile by tile, so the intermediate images of the tile stay in cache
+     * between the stages instead of sweeping the whole frame after every stage.
+     *
+     * Stages get the source tile grown by Halo pixels (a view, no copy) and write the tile result of the same
+     * size into the TileImage of the worker. Only the central part is copied into Dst, so if Halo is not less
+     * than the sum of the radii of all neighbourhood stages the result is identical to running the stages on
+     * the whole image (i.e. FastGaussianBlur::GetRadius() + WindowSize / 2 for the blur followed by Sauvola).
+     * Stages which depend on the whole image (Otsu, Cluster::Clusterize, normalization by maximum)
+     * can't be tiled: run them on Dst afterwards.
+     *
+     * Stages should keep per-worker scratch images (indexed by Worker) to reuse them between the tiles.
+     * \code
+     * std::vector<GrayImage> Gray(ThreadPool::GetDefault()->GetWorkers()); // Pipeline runs on the default pool
+     * TilePipeline<PixelType::RGB24, PixelType::Mono8, BinaryImage> Pipeline(
+     *     [&](const GenericImage<PixelType::RGB24> &Src, BinaryImage &Dst, uint32_t Worker)
+     *     {
+     *         Gray[Worker].Convert(Src);
+     *         FastGaussianBlur::Blur<3>(Gray[Worker], Sigma);
+     *         Dst.Sauvola(Gray[Worker], WindowSize, K);
+     *     }, FastGaussianBlur::GetRadius<3>(Sigma) + WindowSize / 2);
+     * Pipeline.Run(Frame, Mask);
+     * \endcode
+     */
+    template<typename PixelSrc, typename PixelDst, typename TileImage = GenericImage<PixelDst>>
+    class TilePipeline
+    {
+    public:
+        typedef std::function<void(const GenericImage<PixelSrc> &Src, TileImage &Dst, uint32_t Worker)> Stages;
+
+        TilePipeline(const Stages &Function, uint32_t Halo, uint32_t TileWidth = 256, uint32_t TileHeight = 256,
+                     ThreadPool *pPool = nullptr);
+
+        /*!
+         * Run stages over all tiles of Src, Dst is resized to the Src size.
+         */
+        void Run(const GenericImage<PixelSrc> &Src, GenericImage<PixelDst> &Dst);
+
+        /*!
+         * \return Amount of workers, i.e. amount of the per-worker scratch images needed by the stages.
+         */
+        uint32_t GetWorkers() const;
+    private:
+        Stages m_Stages;
+        uint32_t m_Halo;
+        TileScheduler m_Scheduler;
+        std::vector<TileImage> m_Tiles; //< Result of the tile for every worker
+    };
+
+// =======================================================
+
+    inline TileScheduler::TileScheduler(uint32_t TileWidth, uint32_t TileHeight, ThreadPool *pPool)
+            : m_TileWidth(TileWidth),
+              m_TileHeight(TileHeight),
+              m_pPool(pPool)
+    {
+        assert(TileWidth > 0 && TileHeight > 0);
+    }
+
+    inline ThreadPool *TileScheduler::GetPool() const
+    {
+        return (m_pPool != nullptr) ? m_pPool : ThreadPool::GetDefault();
+    }
+
+    inline uint32_t TileScheduler::GetWorkers() const
+    {
+        return GetPool()->GetWorkers();
+    }
+
+    inline Rect<uint32_t> TileScheduler::Expand(const Rect<uint32_t> &Tile, uint32_t Halo, uint32_t Width,
+                                                uint32_t Height)
+    {
+        return Rect<uint32_t>((Tile.top > Halo) ? Tile.top - Halo : 0,
+                              (Tile.left > Halo) ? Tile.left - Halo : 0,
+                              (uint32_t) std::min<uint64_t>((uint64_t) Tile.bottom + Halo, Height - 1),
+                              (uint32_t) std::min<uint64_t>((uint64_t) Tile.right + Halo, Width - 1));
+    }
+
+    inline bool TileScheduler::Pop(TileQueue &Queue, uint32_t &Tile)
+    {
+        std::lock_guard<std::mutex> Lock(Queue.Mutex);
+        if (Queue.Tiles.empty())
+        {
+            return false;
+        }
+        Tile = Queue.Tiles.front();
+        Queue.Tiles.pop_front();
+        return true;
+    }
+
+    inline bool TileScheduler::Steal(std::vector<TileQueue> &Queues, uint32_t Worker, uint32_t &Tile)
+    {
+        for (size_t i = 1; i < Queues.size(); ++i)
+        {
+            TileQueue &Victim = Queues[(Worker + i) % Queues.size()];
+            std::lock_guard<std::mutex> Lock(Victim.Mutex);
+            if (!Victim.Tiles.empty())
+            {
+                Tile = Victim.Tiles.back();
+                Victim.Tiles.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline void TileScheduler::Run(uint32_t Width, uint32_t Height, const TileJob &Function)
+    {
+        if (Width == 0 || Height == 0)
+        {
+            return;
+        }
+        ThreadPool *pPool = GetPool();
+        uint32_t Cols = (Width - 1) / m_TileWidth + 1;
+        uint32_t Rows = (Height - 1) / m_TileHeight + 1;
+        uint64_t Tiles = (uint64_t) Cols * Rows;
+        uint32_t Workers = pPool->GetWorkers();
+        std::vector<TileQueue> Queues(Workers);
+        for (uint32_t w = 0; w < Workers; ++w)
+        {
+            for (uint64_t t = Tiles * w / Workers; t < Tiles * (w + 1) / Workers; ++t)
+            {
+                Queues[w].Tiles.push_back((uint32_t) t);
+            }
+        }
+        pPool->Execute([&](uint32_t Worker)
+                       {
+                           // Queues are made for the amount of workers above: if the pool has been resized since,
+                           // extra workers stay idle and the queues of the missing ones are stolen
+                           if (Worker >= Workers)
+                           {
+                               return;
+                           }
+                           uint32_t Tile = 0;
+                           while (Pop(Queues[Worker], Tile) || Steal(Queues, Worker, Tile))
+                           {
+                               uint32_t Left = (Tile % Cols) * m_TileWidth;
+                               uint32_t Top = (Tile / Cols) * m_TileHeight;
+                               Rect<uint32_t> Rc(Top, Left,
+                                                 (uint32_t) std::min<uint64_t>((uint64_t) Top + m_TileHeight, Height) - 1,
+                                                 (uint32_t) std::min<uint64_t>((uint64_t) Left + m_TileWidth, Width) - 1);
+                               Function(Rc, Worker);
+                           }
+                       });
+    }
+
+    template<typename PixelSrc, typename PixelDst, typename TileImage>
+    TilePipeline<PixelSrc, PixelDst, TileImage>::TilePipeline(const Stages &Function, uint32_t Halo,
+                                                              uint32_t TileWidth, uint32_t TileHeight,
+                                                              ThreadPool *pPool)
+            : m_Stages(Function),
+              m_Halo(Halo),
+              m_Scheduler(TileWidth, TileHeight, pPool)
+    {
+    }
+
+    template<typename PixelSrc, typename PixelDst, typename TileImage>
+    uint32_t TilePipeline<PixelSrc, PixelDst, TileImage>::GetWorkers() const
+    {
+        return m_Scheduler.GetWorkers();
+    }
+
+    template<typename PixelSrc, typename PixelDst, typename TileImage>
+    void TilePipeline<PixelSrc, PixelDst, TileImage>::Run(const GenericImage<PixelSrc> &Src,
+                                                          GenericImage<PixelDst> &Dst)
+    {
+        uint32_t W = Src.GetWidth();
+        uint32_t H = Src.GetHeight();
+        Dst.Create(W, H);
+        if (m_Tiles.size() < m_Scheduler.GetWorkers())
+        {
+            m_Tiles.resize(m_Scheduler.GetWorkers());
+        }
+        m_Scheduler.Run(W, H, [&](const Rect<uint32_t> &Tile, uint32_t Worker)
+        {
+            Rect<uint32_t> Area = TileScheduler::Expand(Tile, m_Halo, W, H);
+            const ConstGenericImageView<PixelSrc> View(Src, Area);
+            TileImage &Out = m_Tiles[Worker];
+            m_Stages(View.GetImage(), Out, Worker);
+            assert(Out.GetWidth() == View.GetImage().GetWidth() && Out.GetHeight() == View.GetImage().GetHeight());
+            size_t RowSize = (size_t) (Tile.right - Tile.left + 1) * GenericImage<PixelDst>::SizeOfPixel;
+            for (uint32_t y = Tile.top; y <= Tile.bottom; ++y)
+            {
+                memcpy(*Dst.GetColRow(Tile.left, y), *Out.GetColRow(Tile.left - Area.left, y - Area.top), RowSize);
+            }
+        });
+    }
+};
+#endif //JIMLIB_TILESCHEDULER_HPP